@@ -47,6 +47,8 @@ Item {
     property real xPrecision: 1/width
     property real yPrecision: 1/height
 
+    property bool dragging: anchorMouse.drag.active
+
     width: 25
     height: width
 
@@ -66,6 +68,7 @@ Item {
         anchors.fill: parent
 
         MouseArea {
+            id: anchorMouse
             anchors.fill: parent
 
             drag {
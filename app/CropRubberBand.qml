@@ -34,7 +34,11 @@ Item {
 
     property bool rubberbandEnabled: visible
 
-    property rect cropRect: Qt.rect(cropFrame.x, cropFrame.y, cropFrame.width, cropFrame.height)
+    // Follows the frame once per event loop pass, an anchor drag moves x, y, width and height one after the other.
+    property rect cropRect
+
+    property bool dragging: frameMouse.drag.active || topLeftAnchor.dragging || topRightAnchor.dragging ||
+                            bottomLeftAnchor.dragging || bottomRightAnchor.dragging
 
     property color backgroundColor: "transparent"
     property color borderColor: "black"
@@ -58,6 +62,8 @@ Item {
 
     onMaxSizeChanged: cropFrame.needsValidation = true
 
+    Component.onCompleted: cropFrame.updateCropRect()
+
     Rectangle {
         id: cropFrame
 
@@ -137,6 +143,10 @@ Item {
             }
         }
 
+        function updateCropRect() {
+            cropRect = Qt.rect(x, y, width, height)
+        }
+
         function resetFrame() {
             if (rubberbandEnabled)
             {
@@ -152,10 +162,10 @@ Item {
         border.width: borderWidth
         border.color: borderColor
 
-        onXChanged: needsValidation = true
-        onYChanged: needsValidation = true
-        onWidthChanged: needsValidation = true
-        onHeightChanged: needsValidation = true
+        onXChanged: { needsValidation = true; Qt.callLater(updateCropRect) }
+        onYChanged: { needsValidation = true; Qt.callLater(updateCropRect) }
+        onWidthChanged: { needsValidation = true; Qt.callLater(updateCropRect) }
+        onHeightChanged: { needsValidation = true; Qt.callLater(updateCropRect) }
 
         onNeedsValidationChanged: if (needsValidation) Qt.callLater(revalidateFrame)
 
@@ -288,6 +298,7 @@ Item {
         }
 
         MouseArea {
+            id: frameMouse
             anchors.fill: parent
 
             drag {
@@ -315,6 +326,7 @@ Item {
         }
 
         CropAnchor {
+            id: topLeftAnchor
             attachTo: Item.TopLeft
 
             anchorEnabled: rubberbandEnabled
@@ -328,6 +340,7 @@ Item {
         }
 
         CropAnchor {
+            id: topRightAnchor
             attachTo: Item.TopRight
 
             anchorEnabled: rubberbandEnabled
@@ -341,6 +354,7 @@ Item {
         }
 
         CropAnchor {
+            id: bottomLeftAnchor
             attachTo: Item.BottomLeft
 
             anchorEnabled: rubberbandEnabled
@@ -354,6 +368,7 @@ Item {
         }
 
         CropAnchor {
+            id: bottomRightAnchor
             attachTo: Item.BottomRight
 
             anchorEnabled: rubberbandEnabled
@@ -75,15 +75,20 @@ Item {
     property bool isCropRectValid: cropRect.x >= 0 && cropRect.y >= 0 && cropRect.width > 0 && cropRect.height > 0
     property bool isCropActionValid: (!resizeSource || !preserveAspectRatio || aspectRatioIndex != 1 || isCropRectValid)
 
-    property bool isReady: faceEnabled &&
-                           isFaceRectValid &&
-                           isHorizontalCountValid &&
-                           isVerticalCountValid &&
-                           isFaceImageValid &&
-                           isResizingNeeded &&
-                           isAspectRatioActionValid &&
-                           isResizeToFitValid &&
-                           isCropActionValid
+    // Set by validate() once per frame of edits, following the face's coalesced changed signal.
+    property bool isReady: false
+
+    function validate() {
+        isReady = faceEnabled &&
+                  isFaceRectValid &&
+                  isHorizontalCountValid &&
+                  isVerticalCountValid &&
+                  isFaceImageValid &&
+                  isResizingNeeded &&
+                  isAspectRatioActionValid &&
+                  isResizeToFitValid &&
+                  isCropActionValid
+    }
 
     function getErrors() {
         var error
@@ -102,11 +107,32 @@ Item {
         return error
     }
 
+    // Preset layouts keep the face rect of the catalog, the views recompute the fit and crop rects.
+    function restore(values) {
+        for (var property in values)
+        {
+            if (property !== "faceRect" || custom)
+            {
+                editor[property] = values[property]
+            }
+        }
+    }
+
     signal startedEditing()
     signal editingFinished()
 
     onEditingChanged: if (editing) startedEditing(); else editingFinished()
 
+    onFaceObjectChanged: Qt.callLater(validate)
+    onSourceStatusChanged: Qt.callLater(validate)
+    onSourceSizeChanged: Qt.callLater(validate)
+    onAspectRatioIndexChanged: Qt.callLater(validate)
+
+    Connections {
+        target: faceObject
+        onChanged: validate()
+    }
+
     implicitWidth: editorInfo.implicitWidth
     implicitHeight: editorInfo.implicitHeight
 
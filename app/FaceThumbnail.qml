@@ -28,6 +28,8 @@ import QtQuick.Controls 2.13
 import QtQuick.Layouts 1.3
 import QtQuick.Dialogs 1.0
 
+import waifu2ugc 1.0
+
 Item {
     id: thumbnail
     property bool enabled
@@ -41,6 +43,8 @@ Item {
     property url faceImage
     property color baseColor
 
+    property real displayScale: 1
+
     property real focusedOpacity: 1
     property real blurredOpacity: 0.75
     property real thumbnailOpacity: 0.75
@@ -66,7 +70,8 @@ Item {
         id: preview
         asynchronous: true
         opacity: thumbnailOpacity
-        source: faceImage ? faceImage : ""
+        source: faceImage != "" ? ImageCache.providerUrl(faceImage) : ""
+        sourceSize: ImageCache.requestSize(width * displayScale, height * displayScale)
         fillMode: Image.PreserveAspectCrop
         anchors.fill: parent
     }
@@ -28,6 +28,7 @@ import QtQuick.Controls 2.13
 import QtQuick.Layouts 1.3
 import QtQuick.Dialogs 1.0
 import QtGraphicalEffects 1.12
+import QtQml 2.13
 
 import waifu2ugc 1.0
 
@@ -37,8 +38,8 @@ Item {
     property FaceEditor editor
 
     property url faceImage: editor.faceImage
-    property size sourceSize: sourceView.sourceSize
-    property var faceStatus: sourceView.status
+    property size sourceSize: sourceProbe.status === Image.Ready ? ImageCache.sourceSize(faceImage) : Qt.size(0, 0)
+    property var faceStatus: sourceProbe.status
 
     property bool resizeSource: editor.resizeSource
     property bool preserveAspectRatio: editor.preserveAspectRatio
@@ -59,6 +60,11 @@ Item {
     property rect totalFitRect: resizeToFitFrame.totalFitRect
     property rect totalCropRect: cropFrame.totalCropRect
 
+    property double openedAt: Date.now()
+
+    // A drag is one update of the face, its properties notify once when it ends.
+    property bool dragging: resizeToFitView.beingDragged || rubberband.dragging
+
     function gcd(numerator, denominator) {
         return (isNaN(denominator) || Math.round(denominator) == 0) ? Math.round(numerator) : gcd(Math.round(denominator), Math.round(numerator % denominator))
     }
@@ -70,6 +76,38 @@ Item {
 
     implicitHeight: mainFrame.implicitHeight
 
+    onFaceImageChanged: openedAt = Date.now()
+
+    onDraggingChanged: {
+        if (editor && editor.faceObject)
+        {
+            if (dragging) editor.faceObject.beginUpdate()
+            else editor.faceObject.endUpdate()
+        }
+    }
+
+    LoggingCategory {
+        id: perf
+        name: "waifu2ugc.perf"
+        defaultLogLevel: LoggingCategory.Warning
+    }
+
+    // Always requests the smallest mip level, so its status does not flip when the views below reload another level
+    Image {
+        id: sourceProbe
+        visible: false
+        asynchronous: true
+        source: faceImage != "" ? ImageCache.providerUrl(faceImage) : ""
+        sourceSize: Qt.size(1, 1)
+
+        onStatusChanged: {
+            if (status === Image.Ready)
+            {
+                console.info(perf, "Opened " + faceImage + " in " + (Date.now() - openedAt) + " ms")
+            }
+        }
+    }
+
     Binding { target: editor; property: "sourceSize"; value: sourceSize }
     Binding { target: editor; property: "sourceStatus"; value: faceStatus }
     Binding { target: editor; property: "fitRect"; value: faceFitRect }
@@ -101,7 +139,7 @@ Item {
                 BusyIndicator {
                     id: loadingSource
                     anchors.centerIn: parent
-                    running: sourceView.status === Image.Loading
+                    running: sourceProbe.status === Image.Loading
                 }
             }
 
@@ -122,7 +160,8 @@ Item {
                     Image {
                         id: sourceView
                         asynchronous: true
-                        source: faceImage ? faceImage : ""
+                        source: faceImage != "" ? ImageCache.providerUrl(faceImage) : ""
+                        sourceSize: ImageCache.requestSize(width, height)
                         fillMode: Image.PreserveAspectFit
                         anchors.fill: parent
                         anchors.margins: sourceFrame.border.width
@@ -173,6 +212,7 @@ Item {
                         id: resizeView
                         asynchronous: true
                         source: sourceView.source
+                        sourceSize: ImageCache.requestSize(width, height)
                         fillMode: Image.Stretch
                         anchors.fill: parent
                         anchors.margins: resizeFrame.border.width
@@ -264,8 +304,8 @@ Item {
                             property rect fitRect
                             property rect scaledFitRect: Qt.rect(fitRect.x / widthScale, fitRect.y / heightScale, fitRect.width / widthScale, fitRect.height / heightScale)
 
-                            property real widthScale: paintedWidth / sourceSize.width
-                            property real heightScale: paintedHeight / sourceSize.height
+                            property real widthScale: paintedWidth / view.sourceSize.width
+                            property real heightScale: paintedHeight / view.sourceSize.height
 
                             function reset() {
                                 x = width / 2 - paintedWidth / 2
@@ -273,19 +313,25 @@ Item {
                                 fitRect = Qt.rect(x, y, width, height)
                             }
 
+                            function updateFitRect() {
+                                fitRect = Qt.rect(x, y, width, height)
+                            }
+
                             width: parent.width
                             height: parent.height
 
                             asynchronous: true
                             source: sourceView.source
+                            sourceSize: ImageCache.requestSize(width, height)
                             fillMode: Image.PreserveAspectFit
                             horizontalAlignment: Image.AlignLeft
                             verticalAlignment: Image.AlignTop
 
                             onStatusChanged: if (status == Image.Ready) reset()
 
-                            onXChanged: fitRect = Qt.rect(x, y, width, height)
-                            onYChanged: fitRect = Qt.rect(x, y, width, height)
+                            // A diagonal drag moves x and y separately, both land in one update.
+                            onXChanged: Qt.callLater(updateFitRect)
+                            onYChanged: Qt.callLater(updateFitRect)
 
                             onWidthChanged: { x = fitRect.x * width / fitRect.width; fitRect = Qt.rect(x, y, width, height) }
                             onHeightChanged: { y = fitRect.y * height / fitRect.height; fitRect = Qt.rect(x, y, width, height) }
@@ -322,11 +368,12 @@ Item {
                         property rect cropRect: rubberband.cropRect
                         property rect scaledCropRect: Qt.rect(cropRect.x / widthScale, cropRect.y / heightScale, cropRect.width / widthScale, cropRect.height / heightScale)
 
-                        property real widthScale: paintedWidth / sourceSize.width
-                        property real heightScale: paintedHeight / sourceSize.height
+                        property real widthScale: paintedWidth / view.sourceSize.width
+                        property real heightScale: paintedHeight / view.sourceSize.height
 
                         asynchronous: true
                         source: sourceView.source
+                        sourceSize: ImageCache.requestSize(width, height)
                         fillMode: Image.PreserveAspectFit
                         anchors.fill: parent
 
@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+import QtQuick 2.13
+import QtQml 2.13
+
+import waifu2ugc 1.0
+
+// Creates the view of a face only when it is shown. A view feeds its editor the source status and
+// the fit/crop rects, so it stays alive while the face has an image and is dropped otherwise.
+Loader {
+    id: loader
+
+    property FaceEditor editor
+    property FaceEditor currentEditor
+
+    property bool current: editor !== null && editor === currentEditor
+    property bool wanted: editor !== null && (current || editor.faceImage != "")
+
+    property double requestedAt: 0
+
+    function update() {
+        if (wanted && source == "")
+        {
+            requestedAt = Date.now()
+            setSource("FaceView.qml", { "editor": editor })
+        }
+        else if (!wanted && source != "")
+        {
+            source = ""
+        }
+    }
+
+    asynchronous: true
+    visible: current && status === Loader.Ready
+
+    onWantedChanged: update()
+    Component.onCompleted: update()
+
+    onLoaded: console.info(perf, "Face view '" + editor.face + "' created in " + (Date.now() - requestedAt) + " ms")
+
+    LoggingCategory {
+        id: perf
+        name: "waifu2ugc.perf"
+        defaultLogLevel: LoggingCategory.Warning
+    }
+}
@@ -37,9 +37,6 @@ Item
 
     property int currentLayoutIndex: comboLayout.currentIndex
 
-    property var defaultLayout: templateLayoutModel.get(0)
-    property var currentLayout: templateLayoutModel.get(currentLayoutIndex)
-
     property bool atLeastOneEnabled: frontEditor.faceEnabled  || topEditor.faceEnabled  ||
                                      rightEditor.faceEnabled  || backEditor.faceEnabled ||
                                      bottomEditor.faceEnabled || leftEditor.faceEnabled
@@ -52,8 +49,8 @@ Item
                                 (!leftEditor.faceEnabled   || leftEditor.isReady)
 
     // TODO: Ver a coisa do template
-    property bool isTemplateLoading: template.source != "" && template.status === Image.Loading
-    property bool isTemplateValid: template.source != "" && template.status === Image.Ready && template.sourceSize.width > 0 && template.sourceSize.height > 0
+    property bool isTemplateLoading: template.templateUrl != "" && templateProbe.status === Image.Loading
+    property bool isTemplateValid: template.templateUrl != "" && templateProbe.status === Image.Ready && template.templateSize.width > 0 && template.templateSize.height > 0
 
     property bool ready: atLeastOneEnabled && editorsReady && !isTemplateLoading && isTemplateValid
 
@@ -86,10 +83,34 @@ Item
         return errors;
     }
 
+    // The previews come from the thumbnail cache, so the last session shows up before any image is decoded.
+    function restoreSession() {
+        var session = TemplateExporter.session()
+
+        if (session.layout === undefined)
+            return
+
+        var index = TemplateCatalog.find(session.layout)
+
+        if (index >= 0)
+            comboLayout.currentIndex = index
+
+        template.customImage = session.customTemplate
+
+        for (var face in editors)
+        {
+            if (session[face] !== undefined)
+                editors[face].restore(session[face])
+        }
+    }
+
+    Component.onCompleted: restoreSession()
+
     implicitWidth: mainFrame.implicitWidth
     implicitHeight: mainFrame.implicitHeight
 
-    Binding { target: TemplateExporter; property: "templateUrl"; value: template.source }
+    Binding { target: TemplateCatalog; property: "currentIndex"; value: currentLayoutIndex }
+    Binding { target: TemplateExporter; property: "templateUrl"; value: template.templateUrl }
 
     Binding { target: frontEditor; property: "faceObject"; value: TemplateExporter.frontFace }
     Binding { target: topEditor; property: "faceObject"; value: TemplateExporter.topFace }
@@ -98,10 +119,6 @@ Item
     Binding { target: bottomEditor; property: "faceObject"; value: TemplateExporter.bottomFace }
     Binding { target: leftEditor; property: "faceObject"; value: TemplateExporter.leftFace }
 
-    TemplateLayoutModel {
-        id: templateLayoutModel
-    }
-
     ColumnLayout {
         id: mainFrame
 
@@ -119,16 +136,20 @@ Item
                     id: template
 
                     property url customImage
-                    property url image: currentLayout.image !== undefined ? currentLayout.image : defaultLayout.image
+                    property url image: TemplateCatalog.currentImage
 
-                    property real widthScale: paintedWidth / sourceSize.width
-                    property real heightScale: paintedHeight / sourceSize.height
+                    property url templateUrl: customImage != "" ? customImage : image
+                    property size templateSize: templateProbe.status === Image.Ready ? ImageCache.sourceSize(templateUrl) : Qt.size(0, 0)
+
+                    property real widthScale: paintedWidth / templateSize.width
+                    property real heightScale: paintedHeight / templateSize.height
                     property real preferredScale: widthScale
 
                     asynchronous: true
                     mipmap: true
 
-                    source: customImage != "" ? customImage : image
+                    source: ImageCache.providerUrl(templateUrl)
+                    sourceSize: ImageCache.requestSize(width, height)
                     fillMode: Image.PreserveAspectFit
 
                     Layout.fillHeight: true
@@ -144,6 +165,14 @@ Item
                         }
                     }
 
+                    Image {
+                        id: templateProbe
+                        visible: false
+                        asynchronous: true
+                        source: template.source
+                        sourceSize: Qt.size(1, 1)
+                    }
+
                     Popup {
                         id: templateError
 
@@ -178,8 +207,8 @@ Item
 
                         clip: true
 
-                        width: template.sourceSize.width
-                        height: template.sourceSize.height
+                        width: template.templateSize.width
+                        height: template.templateSize.height
 
                         visible: template.status != Image.Loading
 
@@ -198,6 +227,7 @@ Item
                             faceText: frontEditor.faceText
                             borderWidth: 3 / template.preferredScale
                             textMarginFactor: 0.5 * template.preferredScale
+                            displayScale: template.preferredScale
                             onFaceClicked: frontEditor.editing = true
                         }
 
@@ -211,6 +241,7 @@ Item
                             faceText: topEditor.faceText
                             borderWidth: 3 / template.preferredScale
                             textMarginFactor: 0.5 * template.preferredScale
+                            displayScale: template.preferredScale
                             onFaceClicked: topEditor.editing = true
                         }
 
@@ -224,6 +255,7 @@ Item
                             faceText: rightEditor.faceText
                             borderWidth: 3 / template.preferredScale
                             textMarginFactor: 0.5 * template.preferredScale
+                            displayScale: template.preferredScale
                             onFaceClicked: rightEditor.editing = true
                         }
 
@@ -237,6 +269,7 @@ Item
                             faceText: backEditor.faceText
                             borderWidth: 3 / template.preferredScale
                             textMarginFactor: 0.5 * template.preferredScale
+                            displayScale: template.preferredScale
                             onFaceClicked: backEditor.editing = true
                         }
 
@@ -250,6 +283,7 @@ Item
                             faceText: bottomEditor.faceText
                             borderWidth: 3 / template.preferredScale
                             textMarginFactor: 0.5 * template.preferredScale
+                            displayScale: template.preferredScale
                             onFaceClicked: bottomEditor.editing = true
                         }
 
@@ -263,6 +297,7 @@ Item
                             faceText: leftEditor.faceText
                             borderWidth: 3 / template.preferredScale
                             textMarginFactor: 0.5 * template.preferredScale
+                            displayScale: template.preferredScale
                             onFaceClicked: leftEditor.editing = true
                         }
                     }
@@ -277,7 +312,7 @@ Item
 
             ComboBox {
                 id: comboLayout
-                model: templateLayoutModel
+                model: TemplateCatalog
                 textRole: "text"
             }
 
@@ -309,35 +344,14 @@ Item
             ColumnLayout {
                 id: facesSection
 
-                function parseRect(text) {
-                    if (text)
-                    {
-                        var numbers = text.split(",")
-                        return Qt.rect(numbers[0], numbers[1], numbers[2], numbers[3])
-                    }
-                    else
-                    {
-                        return undefined
-                    }
-                }
-
-                function layoutRect(index, face) {
-                    var layout = templateLayoutModel.get(index)
-
-                    if (layout[face])
-                    {
-                        return parseRect(layout[face])
-                    }
-                }
-
                 Layout.columnSpan: templateSection.columns
 
                 FaceEditor {
                     id: frontEditor
 
-                    property var layoutRect: facesSection.layoutRect(currentLayoutIndex, face)
+                    property var layoutRect: TemplateCatalog.faceRect(currentLayoutIndex, face)
 
-                    custom: currentLayout.custom
+                    custom: TemplateCatalog.currentCustom
                     Layout.fillWidth: true
 
                     Binding on faceRect { when: frontEditor.layoutRect !== undefined; value: frontEditor.layoutRect }
@@ -346,9 +360,9 @@ Item
                 FaceEditor {
                     id: topEditor
 
-                    property var layoutRect: facesSection.layoutRect(currentLayoutIndex, face)
+                    property var layoutRect: TemplateCatalog.faceRect(currentLayoutIndex, face)
 
-                    custom: currentLayout.custom
+                    custom: TemplateCatalog.currentCustom
                     Layout.fillWidth: true
 
                     Binding on faceRect { when: topEditor.layoutRect !== undefined; value: topEditor.layoutRect }
@@ -357,9 +371,9 @@ Item
                 FaceEditor {
                     id: rightEditor
 
-                    property var layoutRect: facesSection.layoutRect(currentLayoutIndex, face)
+                    property var layoutRect: TemplateCatalog.faceRect(currentLayoutIndex, face)
 
-                    custom: currentLayout.custom
+                    custom: TemplateCatalog.currentCustom
                     Layout.fillWidth: true
 
                     Binding on faceRect { when: rightEditor.layoutRect !== undefined; value: rightEditor.layoutRect }
@@ -368,9 +382,9 @@ Item
                 FaceEditor {
                     id: backEditor
 
-                    property var layoutRect: facesSection.layoutRect(currentLayoutIndex, face)
+                    property var layoutRect: TemplateCatalog.faceRect(currentLayoutIndex, face)
 
-                    custom: currentLayout.custom
+                    custom: TemplateCatalog.currentCustom
                     Layout.fillWidth: true
 
                     Binding on faceRect { when: backEditor.layoutRect !== undefined; value: backEditor.layoutRect }
@@ -379,9 +393,9 @@ Item
                 FaceEditor {
                     id: bottomEditor
 
-                    property var layoutRect: facesSection.layoutRect(currentLayoutIndex, face)
+                    property var layoutRect: TemplateCatalog.faceRect(currentLayoutIndex, face)
 
-                    custom: currentLayout.custom
+                    custom: TemplateCatalog.currentCustom
                     Layout.fillWidth: true
 
                     Binding on faceRect { when: bottomEditor.layoutRect !== undefined; value: bottomEditor.layoutRect }
@@ -390,9 +404,9 @@ Item
                 FaceEditor {
                     id: leftEditor
 
-                    property var layoutRect: facesSection.layoutRect(currentLayoutIndex, face)
+                    property var layoutRect: TemplateCatalog.faceRect(currentLayoutIndex, face)
 
-                    custom: currentLayout.custom
+                    custom: TemplateCatalog.currentCustom
                     Layout.fillWidth: true
 
                     Binding on faceRect { when: leftEditor.layoutRect !== undefined; value: leftEditor.layoutRect }
@@ -38,6 +38,21 @@ Item {
     property string nxl_path: "file:///C:/Nexon/Library/maplestory2/appdata/Custom/Cube"
     property string steam_path: "file:///C:/Program Files (x86)/Steam/steamapps/common/MapleStory 2/Custom/Cube"
 
+    // The other installed client, which can receive the same tiles without rendering them again.
+    property string mirrorDirectory: {
+        if (outputDirectory.toString() === nxl_path && TemplateExporter.directoryExists(steam_path))
+        {
+            return steam_path
+        }
+
+        if (outputDirectory.toString() === steam_path && TemplateExporter.directoryExists(nxl_path))
+        {
+            return nxl_path
+        }
+
+        return ""
+    }
+
     signal showErrors()
 
     implicitWidth: mainFrame.implicitWidth
@@ -139,13 +154,60 @@ Item {
             }
         }
 
+        CheckBox {
+            id: checkOptimizeOutput
+            text: qsTr("Optimize file size")
+            checked: TemplateExporter.optimizeOutput
+            enabled: !TemplateExporter.busy
+            onCheckedChanged: TemplateExporter.optimizeOutput = checked
+        }
+
+        CheckBox {
+            text: qsTr("Allow lossy palette")
+            checked: TemplateExporter.quantizeOutput
+            enabled: !TemplateExporter.busy && checkOptimizeOutput.checked
+            visible: checkOptimizeOutput.checked
+            Layout.leftMargin: 20
+            onCheckedChanged: TemplateExporter.quantizeOutput = checked
+        }
+
+        CheckBox {
+            text: qsTr("Export all %1 variants of this template").arg(TemplateCatalog.currentVariantCount)
+            checked: TemplateExporter.exportVariants
+            enabled: !TemplateExporter.busy
+            visible: TemplateCatalog.currentVariantCount > 1
+            onCheckedChanged: TemplateExporter.exportVariants = checked
+        }
+
+        CheckBox {
+            id: checkMirror
+            text: mirrorDirectory === nxl_path ? qsTr("Also export to the NXL client") : qsTr("Also export to the Steam client")
+            enabled: !TemplateExporter.busy
+            visible: mirrorDirectory !== ""
+        }
+
+        CheckBox {
+            text: qsTr("Re-export when the images change")
+            checked: TemplateExporter.watching
+            onCheckedChanged: TemplateExporter.watching = checked
+        }
+
         RowLayout {
             Button {
                 id: btnExport
                 text: qsTr("Export")
                 enabled: ready && outputDirectory != "" && !TemplateExporter.busy
                 visible: !TemplateExporter.busy
-                onClicked: TemplateExporter.exportToDirectory(outputDirectory)
+                onClicked: {
+                    if (checkMirror.visible && checkMirror.checked)
+                    {
+                        TemplateExporter.exportToDirectories([outputDirectory, mirrorDirectory])
+                    }
+                    else
+                    {
+                        TemplateExporter.exportToDirectory(outputDirectory)
+                    }
+                }
             }
 
             Button {
@@ -154,6 +216,20 @@ Item {
                 onClicked: TemplateExporter.cancel()
             }
 
+            Button {
+                text: qsTr("Show tiles")
+                enabled: TemplateExporter.tiles.count > 0 && !TemplateExporter.busy
+                visible: !TemplateExporter.busy
+                onClicked: tileGallery.open()
+            }
+
+            Button {
+                text: qsTr("Save job")
+                enabled: ready && !TemplateExporter.busy
+                visible: !TemplateExporter.busy
+                onClicked: saveJobDialog.open()
+            }
+
             Button {
                 text: qsTr("?")
                 enabled: !btnExport.enabled
@@ -176,6 +252,19 @@ Item {
             }
         }
 
+        TileGallery {
+            id: tileGallery
+        }
+
+        Labs.FileDialog {
+            id: saveJobDialog
+            title: qsTr("Save export job")
+            fileMode: Labs.FileDialog.SaveFile
+            defaultSuffix: "json"
+            nameFilters: [ qsTr("Job files (*.json)") ]
+            onAccepted: TemplateExporter.saveJob(file)
+        }
+
         Text {
             text: TemplateExporter.statusMessage
             visible: TemplateExporter.busy
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+import QtQuick 2.13
+import QtQuick.Controls 2.13
+import QtQuick.Layouts 1.3
+
+import waifu2ugc 1.0
+
+// Only the visible cells exist, and thumbnails are decoded at cell size on the image loader threads.
+Popup {
+    id: gallery
+
+    property TileListModel tiles: TemplateExporter.tiles
+    property int cellSize: 128
+
+    modal: true
+    focus: true
+    anchors.centerIn: Overlay.overlay
+    width: Overlay.overlay ? Overlay.overlay.width * 0.8 : 800
+    height: Overlay.overlay ? Overlay.overlay.height * 0.8 : 600
+
+    ColumnLayout {
+        anchors.fill: parent
+
+        Label {
+            text: qsTr("%1 tiles in %2").arg(tiles.count).arg(tiles.directory.toString().replace("file://", ""))
+            elide: Text.ElideMiddle
+            Layout.fillWidth: true
+        }
+
+        GridView {
+            id: grid
+            clip: true
+            model: tiles
+            cellWidth: cellSize + 10
+            cellHeight: cellSize + 40
+            cacheBuffer: cellHeight * 2
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+
+            ScrollBar.vertical: ScrollBar { }
+
+            delegate: Column {
+                width: grid.cellWidth
+                spacing: 2
+
+                Item {
+                    width: cellSize
+                    height: cellSize
+                    anchors.horizontalCenter: parent.horizontalCenter
+
+                    Image {
+                        anchors.fill: parent
+                        asynchronous: true
+                        cache: false
+                        fillMode: Image.PreserveAspectFit
+                        source: thumbnail
+                        sourceSize: Qt.size(cellSize, cellSize)
+                    }
+
+                    Rectangle {
+                        anchors.fill: parent
+                        color: "transparent"
+                        border.color: status === "written" ? "transparent" : "red"
+                        border.width: 2
+                    }
+                }
+
+                Label {
+                    text: face + " " + position
+                    width: parent.width
+                    horizontalAlignment: Text.AlignHCenter
+                    elide: Text.ElideRight
+                }
+
+                Label {
+                    text: status === "written" ? Qt.locale().formattedDataSize(size) : qsTr("Missing")
+                    width: parent.width
+                    horizontalAlignment: Text.AlignHCenter
+                    color: status === "written" ? "gray" : "red"
+                    font.pointSize: 8
+                }
+            }
+        }
+
+        Button {
+            text: qsTr("Close")
+            Layout.alignment: Qt.AlignRight
+            onClicked: gallery.close()
+        }
+    }
+}
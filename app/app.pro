@@ -0,0 +1,73 @@
+QT += quick quickcontrols2 widgets network concurrent
+
+TARGET = waifu2ugc
+
+CONFIG += c++11
+
+# The following define makes your compiler emit warnings if you use
+# any Qt feature that has been marked deprecated (the exact warnings
+# depend on your compiler). Refer to the documentation for the
+# deprecated API to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+        exportcommandline.cpp \
+        exportwatcher.cpp \
+        frametimer.cpp \
+        gridoverlay.cpp \
+        logging.cpp \
+        main.cpp \
+        mipimageprovider.cpp \
+        renderservice.cpp \
+        templatecatalog.cpp \
+        templateexporter.cpp \
+        templateface.cpp \
+        tilelistmodel.cpp \
+        tilethumbnailprovider.cpp
+
+RESOURCES += qml.qrc
+
+INCLUDEPATH += $$PWD/../core
+DEPENDPATH += $$PWD/../core
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../core/release/
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../core/debug/
+else: LIBS += -L$$OUT_PWD/../core/
+
+LIBS += -lwaifu2ugc-core
+
+waifu2ugc_static {
+    DEFINES += WAIFU2UGC_CORE_STATIC
+    unix: LIBS += -lz
+}
+
+# Additional import path used to resolve QML modules in Qt Creator's code model
+QML_IMPORT_PATH =
+
+# Additional import path used to resolve QML modules just for Qt Quick Designer
+QML_DESIGNER_IMPORT_PATH =
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+HEADERS += \
+    exportcommandline.h \
+    exportwatcher.h \
+    frametimer.h \
+    gridoverlay.h \
+    logging.h \
+    mipimageprovider.h \
+    renderservice.h \
+    templatecatalog.h \
+    templateexporter.h \
+    templateface.h \
+    templatelayout.h \
+    tilelistmodel.h \
+    tilethumbnailprovider.h
@@ -0,0 +1,438 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "exportcommandline.h"
+#include "exportjob.h"
+#include "imagecache.h"
+#include "renderservice.h"
+#include "shardspec.h"
+#include "tilerenderer.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QSaveFile>
+#include <QTextStream>
+
+bool ExportCommandLine::isRequested(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (qstrcmp(argv[i], "--job") == 0 || qstrncmp(argv[i], "--job=", 6) == 0 ||
+			qstrcmp(argv[i], "--run-plan") == 0 || qstrncmp(argv[i], "--run-plan=", 11) == 0 ||
+			qstrcmp(argv[i], "--serve") == 0 || qstrncmp(argv[i], "--serve=", 8) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int ExportCommandLine::run(const QStringList& arguments)
+{
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(tr("Exports a saved waifu2ugc job without the user interface."));
+	parser.addHelpOption();
+	parser.addVersionOption();
+
+	QCommandLineOption jobOption("job", tr("Job file saved from the application."), tr("file"));
+	QCommandLineOption outputOption("output", tr("Directory receiving the tiles, repeat it to write the same tiles to several directories."), tr("directory"), QDir::currentPath());
+	QCommandLineOption shardOption("shard", tr("Render only shard i of N, e.g. 0/4."), tr("i/N"));
+	QCommandLineOption mergeOption("merge", tr("Verify that all N shards in every output directory are complete."), tr("N"));
+	QCommandLineOption optimizeOption("optimize", tr("Optimize the file size of the tiles."));
+	QCommandLineOption quantizeOption("quantize", tr("Allow lossy palettes when optimizing."));
+	QCommandLineOption dryRunOption("dry-run", tr("Print what the export would produce without rendering anything."));
+	QCommandLineOption planOption("plan", tr("Write the compiled export plan to a file."), tr("file"));
+	QCommandLineOption runPlanOption("run-plan", tr("Render a plan written by --plan instead of compiling the job, --job then only adds its options."), tr("file"));
+	QCommandLineOption serveOption("serve", tr("Keep running and accept jobs on a local socket."), tr("name"));
+	QCommandLineOption batchOption("batch", tr("Render every image in a directory, or listed one per line in a text file, with the job's layout."), tr("path"));
+	QCommandLineOption facesOption("faces", tr("Faces replaced by the batch images, all enabled ones by default."), tr("front,top,..."));
+
+	parser.addOptions({ jobOption, outputOption, shardOption, mergeOption, optimizeOption, quantizeOption, dryRunOption, planOption, runPlanOption,
+						serveOption, batchOption, facesOption });
+	parser.process(arguments);
+
+	if (parser.isSet(serveOption))
+	{
+		RenderService service;
+		QString error;
+
+		if (!service.listen(parser.value(serveOption), &error))
+		{
+			err << error << endl;
+			return 1;
+		}
+
+		out << tr("Listening on '%1'.").arg(parser.value(serveOption)) << endl;
+
+		return QCoreApplication::exec();
+	}
+
+	ExportJob job;
+	ExportPlan plan;
+	QString error;
+
+	if (parser.isSet(runPlanOption) && !ExportPlan::load(parser.value(runPlanOption), plan, &error))
+	{
+		err << error << endl;
+		return 1;
+	}
+
+	if ((parser.isSet(jobOption) || !parser.isSet(runPlanOption)) && !ExportJob::load(parser.value(jobOption), job, &error))
+	{
+		err << error << endl;
+		return 1;
+	}
+
+	// The plan carries the job it was compiled from, which is what gets rendered.
+	if (parser.isSet(runPlanOption))
+	{
+		job.data() = plan.data();
+	}
+
+	TileOptimizer::Options& options = job.options();
+
+	options.optimize = options.optimize || parser.isSet(optimizeOption);
+	options.quantize = options.quantize || parser.isSet(quantizeOption);
+
+	QSize tileSize = job.templateSize(&error);
+
+	if (!tileSize.isValid())
+	{
+		err << error << endl;
+		return 1;
+	}
+
+	if (!parser.isSet(runPlanOption))
+	{
+		plan = ExportPlan::compile(job.data(), tileSize);
+	}
+	else if (plan.tileSize() != tileSize)
+	{
+		err << tr("The plan was compiled for a %1x%2 template, the template is now %3x%4.")
+			   .arg(plan.tileSize().width()).arg(plan.tileSize().height()).arg(tileSize.width()).arg(tileSize.height()) << endl;
+		return 1;
+	}
+
+	if (parser.isSet(planOption))
+	{
+		QSaveFile file(parser.value(planOption));
+
+		if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(plan.toJson()).toJson()) < 0 || !file.commit())
+		{
+			err << tr("Failed to write the plan to:\r\n%1\r\n%2").arg(parser.value(planOption), file.errorString()) << endl;
+			return 1;
+		}
+	}
+
+	TileRenderer renderer(plan);
+	QStringList directories = parser.values(outputOption);
+
+	if (parser.isSet(batchOption))
+	{
+		return runBatch(job, plan, parser.value(batchOption), parser.value(facesOption), directories);
+	}
+
+	if (parser.isSet(mergeOption))
+	{
+		bool ok = false;
+		int count = parser.value(mergeOption).toInt(&ok);
+
+		if (!ok || count < 1)
+		{
+			err << tr("Invalid shard count: %1").arg(parser.value(mergeOption)) << endl;
+			return 1;
+		}
+
+		// Shards write their tiles and manifests to every output, each one has to be complete.
+		bool complete = true;
+
+		for (const QString& output : directories)
+		{
+			QStringList problems;
+
+			if (!renderer.verifyShards(output, count, &problems))
+			{
+				for (const auto& problem : problems)
+				{
+					err << (directories.count() > 1 ? output + ": " : QString()) << problem << endl;
+				}
+
+				complete = false;
+			}
+		}
+
+		if (!complete)
+		{
+			return 2;
+		}
+
+		for (const QString& output : directories)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				ShardSpec shard;
+				ShardSpec::parse(QString("%1/%2").arg(i).arg(count), shard);
+
+				QFile::remove(QDir(output).filePath(TileRenderer::manifestName(shard)));
+			}
+		}
+
+		out << tr("%1 tiles verified from %2 shards.").arg(plan.tiles().count()).arg(count) << endl;
+		return 0;
+	}
+
+	ShardSpec shard;
+
+	if (parser.isSet(shardOption) && !ShardSpec::parse(parser.value(shardOption), shard))
+	{
+		err << tr("Invalid shard, expected i/N: %1").arg(parser.value(shardOption)) << endl;
+		return 1;
+	}
+
+	ExportPlan::Calibration calibration = ExportPlan::Calibration::load(options.optimize);
+	QVector<int> selection = plan.select(shard);
+	ExportPlan::Estimate estimate = plan.estimate(selection, calibration);
+
+	if (parser.isSet(dryRunOption))
+	{
+		for (int i : selection)
+		{
+			out << plan.tiles()[i].fileName << endl;
+		}
+
+		out << estimate.text() << endl;
+		return 0;
+	}
+
+	int reported = -1;
+
+	TileRenderer::Callbacks callbacks;
+	callbacks.progress = [&out, &reported](qreal progress) {
+		int percent = int(progress * 100);
+
+		if (percent / 10 != reported / 10)
+		{
+			reported = percent;
+			out << tr("%1%...").arg(percent) << endl;
+		}
+	};
+
+	TileRenderer::Report report;
+	bool rendered = job.render(plan, selection, directories, callbacks, report, &error);
+
+	if (report.written > 0 || report.failed > 0)
+	{
+		out << report.text(options.optimize) << endl;
+		out << report.pipeline << endl;
+	}
+
+	for (const QString& output : directories)
+	{
+		if (shard.isSharded() && rendered && !renderer.writeManifest(output, shard, report))
+		{
+			err << tr("Failed to write the manifest for shard %1.").arg(shard.toString()) << endl;
+			return 1;
+		}
+	}
+
+	if (!rendered)
+	{
+		err << error << endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+// Every design shares the layout, so the plan is compiled and the template decoded once for the whole batch.
+int ExportCommandLine::runBatch(const ExportJob& job, const ExportPlan& plan, const QString& path, const QString& faces, const QStringList& directories)
+{
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+
+	QStringList designs;
+	QFileInfo info(path);
+
+	if (info.isDir())
+	{
+		QStringList filters;
+
+		for (const auto& format : QImageReader::supportedImageFormats())
+		{
+			filters.append("*." + QString::fromLatin1(format));
+		}
+
+		for (const auto& file : QDir(path).entryInfoList(filters, QDir::Files, QDir::Name))
+		{
+			designs.append(file.absoluteFilePath());
+		}
+	}
+	else
+	{
+		QFile list(path);
+
+		if (!list.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			err << tr("Failed to open batch list:\r\n%1\r\n%2").arg(path, list.errorString()) << endl;
+			return 1;
+		}
+
+		while (!list.atEnd())
+		{
+			QString line = QString::fromUtf8(list.readLine()).trimmed();
+
+			if (!line.isEmpty())
+			{
+				designs.append(info.dir().absoluteFilePath(line));
+			}
+		}
+	}
+
+	QList<FaceData::FaceIndex> targets;
+
+	for (const auto& name : faces.split(',', QString::SkipEmptyParts))
+	{
+		FaceData::FaceIndex index = FaceData::indexFromName(name.trimmed());
+
+		if (index == FaceData::INVALID)
+		{
+			err << tr("Unknown face: %1").arg(name) << endl;
+			return 1;
+		}
+
+		if (!job.data().face(index).enabled())
+		{
+			err << tr("Face '%1' is not enabled in the job.").arg(name) << endl;
+			return 1;
+		}
+
+		targets.append(index);
+	}
+
+	if (targets.isEmpty())
+	{
+		for (const auto& face : job.data().faces())
+		{
+			if (face.enabled())
+			{
+				targets.append(face.index());
+			}
+		}
+	}
+
+	if (designs.isEmpty() || targets.isEmpty())
+	{
+		err << tr("Nothing to render, the batch has no images or the job has no enabled faces.") << endl;
+		return 1;
+	}
+
+	QString error;
+	QImage templateImage = ImageCache::instance()->image(job.data().source().templateUrl(), &error);
+
+	if (templateImage.isNull())
+	{
+		err << error << endl;
+		return 1;
+	}
+
+	QVector<int> selection = plan.select(ShardSpec());
+
+	// The template bands are the same in every design, they are encoded once for the batch.
+	const PngBandEncoder bands = TileRenderer(plan).templateBands(templateImage);
+
+	int failures = 0;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QVector<TileRenderer::Report> reports(designs.count());
+
+	// One design at a time on this thread: each render already spreads its tiles over every core, and remote
+	// inputs are downloaded through this thread's event loop.
+	for (int i = 0; i < designs.count(); ++i)
+	{
+		ExportJob design = job;
+
+		for (auto index : targets)
+		{
+			design.data().face(index).faceImageUrl() = QUrl::fromLocalFile(designs[i]);
+		}
+
+		QString designError;
+		QStringList designDirectories;
+
+		// Every output gets the design's folder, TileWriter writes each tile to all of them.
+		for (const QString& directory : directories)
+		{
+			designDirectories.append(QDir(directory).filePath(QFileInfo(designs[i]).completeBaseName()));
+		}
+
+		ExportJob::Inputs inputs;
+		inputs.templateBands = bands;
+
+		// Each render records its own calibration, the designs run one after another.
+		bool rendered = design.loadImages(inputs, QStringList(), TileRenderer::Callbacks(), &designError) &&
+						design.render(plan, selection, inputs, designDirectories, TileRenderer::Callbacks(), reports[i], &designError);
+
+		if (rendered)
+		{
+			out << QFileInfo(designs[i]).fileName() << ": " << reports[i].text(job.options().optimize) << endl;
+		}
+		else
+		{
+			err << QFileInfo(designs[i]).fileName() << ": " << designError << endl;
+			++failures;
+		}
+	}
+
+	int tiles = 0;
+	qint64 bytes = 0;
+
+	for (const auto& report : reports)
+	{
+		tiles += report.written;
+		bytes += report.writtenBytes;
+	}
+
+	double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-3);
+
+	out << tr("%1 designs, %2 tiles, %3 in %4 s (%5 tiles/s, %6/s).")
+		   .arg(designs.count())
+		   .arg(tiles)
+		   .arg(QLocale().formattedDataSize(bytes))
+		   .arg(seconds, 0, 'f', 1)
+		   .arg(tiles / seconds, 0, 'f', 1)
+		   .arg(QLocale().formattedDataSize(qint64(bytes / seconds))) << endl;
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef EXPORTCOMMANDLINE_H
+#define EXPORTCOMMANDLINE_H
+
+#include <QCoreApplication>
+#include <QStringList>
+
+class ExportJob;
+class ExportPlan;
+
+// Renders a saved job without the user interface, optionally as one shard of a larger export,
+// or serves jobs from other processes until killed.
+class ExportCommandLine
+{
+	Q_DECLARE_TR_FUNCTIONS(ExportCommandLine)
+
+public:
+	static bool isRequested(int argc, char* argv[]);
+	static int run(const QStringList& arguments);
+
+private:
+	static int runBatch(const ExportJob& job, const ExportPlan& plan, const QString& path, const QString& faces, const QStringList& directories);
+};
+
+#endif // EXPORTCOMMANDLINE_H
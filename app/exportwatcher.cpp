@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "exportwatcher.h"
+
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+ExportWatcher::ExportWatcher(QObject* parent) :
+	QObject(parent),
+	m_watcher(new QFileSystemWatcher(this)),
+	m_debounce(new QTimer(this))
+{
+	m_debounce->setSingleShot(true);
+	m_debounce->setInterval(m_debounceInterval);
+
+	connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &ExportWatcher::fileChanged);
+	connect(m_debounce, &QTimer::timeout, this, &ExportWatcher::flush);
+}
+
+void ExportWatcher::watch(const QHash<QString, QUrl>& sources)
+{
+	clear();
+
+	for (auto it = sources.begin(); it != sources.end(); ++it)
+	{
+		if (it.value().isLocalFile())
+		{
+			m_keys[it.value().toLocalFile()].append(it.key());
+		}
+	}
+
+	if (!m_keys.isEmpty())
+	{
+		m_watcher->addPaths(m_keys.keys());
+	}
+}
+
+void ExportWatcher::clear()
+{
+	m_debounce->stop();
+	m_changed.clear();
+	m_retries.clear();
+	m_keys.clear();
+
+	if (!m_watcher->files().isEmpty())
+	{
+		m_watcher->removePaths(m_watcher->files());
+	}
+}
+
+void ExportWatcher::fileChanged(const QString& path)
+{
+	if (m_keys.contains(path))
+	{
+		m_changed.insert(path);
+		m_debounce->start();
+	}
+}
+
+// Editors that save by replacing the file make the watch drop it, so it is added back here. A file still missing
+// is waited for over a few more intervals without holding back the ones already saved, then given up on.
+void ExportWatcher::flush()
+{
+	QStringList keys;
+	QSet<QString> waiting;
+
+	for (const auto& path : m_changed)
+	{
+		if (!QFileInfo::exists(path))
+		{
+			if (++m_retries[path] < m_maxRetries)
+			{
+				waiting.insert(path);
+			}
+			else
+			{
+				m_retries.remove(path);
+				emit missing(path);
+			}
+
+			continue;
+		}
+
+		m_retries.remove(path);
+
+		if (!m_watcher->files().contains(path))
+		{
+			m_watcher->addPath(path);
+		}
+
+		keys.append(m_keys.value(path));
+	}
+
+	m_changed = waiting;
+
+	if (!m_changed.isEmpty())
+	{
+		m_debounce->start();
+	}
+
+	if (!keys.isEmpty())
+	{
+		emit changed(keys);
+	}
+}
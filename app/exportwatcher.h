@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef EXPORTWATCHER_H
+#define EXPORTWATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QUrl>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Watches the local inputs of an export and reports which of them changed once a burst of saves settles.
+class ExportWatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit ExportWatcher(QObject* parent = nullptr);
+
+	void watch(const QHash<QString, QUrl>& sources);
+	void clear();
+
+signals:
+	void changed(const QStringList& keys);
+	void missing(const QString& path); // removed and not back after m_maxRetries intervals, no longer watched
+
+private slots:
+	void fileChanged(const QString& path);
+	void flush();
+
+private:
+	QFileSystemWatcher* m_watcher;
+	QTimer* m_debounce;
+
+	QHash< QString, QStringList > m_keys;
+	QSet<QString> m_changed;
+	QHash<QString, int> m_retries;
+
+	static constexpr int m_debounceInterval = 500;
+	static constexpr int m_maxRetries = 10;
+};
+
+#endif // EXPORTWATCHER_H
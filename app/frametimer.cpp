@@ -22,42 +22,43 @@
  * SOFTWARE.
 */
 
-#include <QApplication>
-#include <QQmlApplicationEngine>
-#include <QQuickStyle>
-#include <QQuickWindow>
-#include <QQmlContext>
-#include <QLoggingCategory>
+#include "frametimer.h"
+#include "logging.h"
 
-#include "templateexporter.h"
-#include "templateface.h"
+#include <QQuickWindow>
 
-int main(int argc, char* argv[])
+// Both signals come from the render thread, which is the only one touching the counters.
+FrameTimer::FrameTimer(QQuickWindow* window) : QObject(window)
 {
-	QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+	connect(window, &QQuickWindow::beforeSynchronizing, this, &FrameTimer::frameStarted, Qt::DirectConnection);
+	connect(window, &QQuickWindow::frameSwapped, this, &FrameTimer::frameFinished, Qt::DirectConnection);
+}
 
-	QApplication app(argc, argv);
+void FrameTimer::frameStarted()
+{
+	m_frame.start();
+}
 
-	app.setOrganizationName("Aruraune");
-	app.setOrganizationDomain("Aruraune");
-	app.setApplicationName("waifu2ugc");
-	app.setApplicationDisplayName("waifu2ugc");
-	app.setApplicationVersion("1.0-alpha");
+void FrameTimer::frameFinished()
+{
+	if (!m_frame.isValid())
+	{
+		return;
+	}
 
-	QQuickStyle::setStyle("Default");
+	qint64 elapsed = m_frame.nsecsElapsed();
 
-	qmlRegisterSingletonType<TemplateExporter>("waifu2ugc", 1, 0, "TemplateExporter", &TemplateExporter::qmlInstance);
-	qmlRegisterUncreatableType<TemplateFace>("waifu2ugc", 1, 0, "TemplateFace", "TemplateFace cannot be created in QML.");
+	m_total += elapsed;
+	m_worst = std::max(m_worst, elapsed);
 
-	QQmlApplicationEngine engine;
+	if (++m_frames == m_reportInterval)
+	{
+		qCInfo(lcPerf, "Frames: %.2f ms average, %.2f ms worst over %d frames", m_total / 1e6 / m_frames, m_worst / 1e6, m_frames);
 
-	const QUrl url(QStringLiteral("qrc:/main.qml"));
-	QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
-					 &app, [url](QObject* obj, const QUrl& objUrl) {
-		if (!obj && url == objUrl)
-			QCoreApplication::exit(-1);
-	}, Qt::QueuedConnection);
-	engine.load(url);
+		m_frames = 0;
+		m_total = 0;
+		m_worst = 0;
+	}
 
-	return app.exec();
+	m_frame.invalidate();
 }
@@ -22,53 +22,33 @@
  * SOFTWARE.
 */
 
-#include "exportdata.h"
+#ifndef FRAMETIMER_H
+#define FRAMETIMER_H
 
-int ExportData::getXAxisSize() const {
-	int count = 0;
+#include <QElapsedTimer>
+#include <QObject>
 
-	for (auto& face : m_faces)
-	{
-		if (face.enabled() && face.affectsXHorizontally())
-		{
-			count = std::max(count, face.horizontalCount());
-		}
-	}
+class QQuickWindow;
 
-	return count;
-}
+// Logs how long the scene graph takes to synchronize and render a frame, averaged over a few seconds of frames.
+class FrameTimer : public QObject
+{
+	Q_OBJECT
 
-int ExportData::getYAxisSize() const {
-	int count = 0;
+public:
+	explicit FrameTimer(QQuickWindow* window);
 
-	for (auto& face : m_faces)
-	{
-		if (face.enabled() && face.affectsYVertically())
-		{
-			count = std::max(count, face.verticalCount());
-		}
-	}
+private:
+	void frameStarted();
+	void frameFinished();
 
-	return count;
-}
+	QElapsedTimer m_frame;
 
-int ExportData::getZAxisSize() const {
-	int count = 0;
+	int m_frames = 0;
+	qint64 m_total = 0;
+	qint64 m_worst = 0;
 
-	for (auto& face : m_faces)
-	{
-		if (face.enabled())
-		{
-			if (face.affectsZHorizontally())
-			{
-				count = std::max(count, face.horizontalCount());
-			}
-			else if (face.affectsZVertically())
-			{
-				count = std::max(count, face.verticalCount());
-			}
-		}
-	}
+	static constexpr int m_reportInterval = 120;
+};
 
-	return count;
-}
+#endif // FRAMETIMER_H
@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "gridoverlay.h"
+
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+
+GridOverlay::GridOverlay(QQuickItem* parent) : QQuickItem(parent)
+{
+	setFlag(ItemHasContents, true);
+}
+
+int GridOverlay::horizontalCount() const
+{
+	return m_horizontalCount;
+}
+
+void GridOverlay::setHorizontalCount(int horizontalCount)
+{
+	if (m_horizontalCount != horizontalCount)
+	{
+		m_horizontalCount = horizontalCount;
+		emit horizontalCountChanged();
+		update();
+	}
+}
+
+int GridOverlay::verticalCount() const
+{
+	return m_verticalCount;
+}
+
+void GridOverlay::setVerticalCount(int verticalCount)
+{
+	if (m_verticalCount != verticalCount)
+	{
+		m_verticalCount = verticalCount;
+		emit verticalCountChanged();
+		update();
+	}
+}
+
+qreal GridOverlay::lineWidth() const
+{
+	return m_lineWidth;
+}
+
+void GridOverlay::setLineWidth(qreal lineWidth)
+{
+	if (!qFuzzyCompare(m_lineWidth, lineWidth))
+	{
+		m_lineWidth = lineWidth;
+		emit lineWidthChanged();
+		update();
+	}
+}
+
+QColor GridOverlay::color() const
+{
+	return m_color;
+}
+
+void GridOverlay::setColor(const QColor& color)
+{
+	if (m_color != color)
+	{
+		m_color = color;
+		m_colorChanged = true;
+		emit colorChanged();
+		update();
+	}
+}
+
+void GridOverlay::geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry)
+{
+	QQuickItem::geometryChanged(newGeometry, oldGeometry);
+
+	if (newGeometry.size() != oldGeometry.size())
+	{
+		update();
+	}
+}
+
+// Lines are thin quads rather than GL lines, whose width is not supported everywhere.
+QSGNode* GridOverlay::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data)
+{
+	Q_UNUSED(data)
+
+	auto node = static_cast<QSGGeometryNode*>(oldNode);
+
+	if (node == nullptr)
+	{
+		node = new QSGGeometryNode;
+
+		auto geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+		geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+
+		node->setGeometry(geometry);
+		node->setFlag(QSGNode::OwnsGeometry);
+
+		node->setMaterial(new QSGFlatColorMaterial);
+		node->setFlag(QSGNode::OwnsMaterial);
+
+		m_colorChanged = true;
+	}
+
+	int horizontalLines = std::max(0, m_horizontalCount - 1);
+	int verticalLines = std::max(0, m_verticalCount - 1);
+	int vertexCount = (horizontalLines + verticalLines) * 6;
+
+	QSGGeometry* geometry = node->geometry();
+
+	if (geometry->vertexCount() != vertexCount)
+	{
+		geometry->allocate(vertexCount);
+	}
+
+	QSGGeometry::Point2D* vertices = geometry->vertexDataAsPoint2D();
+	qreal half = m_lineWidth / 2;
+
+	auto quad = [&vertices](float left, float top, float right, float bottom) {
+		vertices[0].set(left, top);
+		vertices[1].set(right, top);
+		vertices[2].set(left, bottom);
+		vertices[3].set(right, top);
+		vertices[4].set(right, bottom);
+		vertices[5].set(left, bottom);
+
+		vertices += 6;
+	};
+
+	for (int h = 1; h <= horizontalLines; ++h)
+	{
+		qreal x = width() * h / m_horizontalCount;
+		quad(float(x - half), 0.0f, float(x + half), float(height()));
+	}
+
+	for (int v = 1; v <= verticalLines; ++v)
+	{
+		qreal y = height() * v / m_verticalCount;
+		quad(0.0f, float(y - half), float(width()), float(y + half));
+	}
+
+	node->markDirty(QSGNode::DirtyGeometry);
+
+	if (m_colorChanged)
+	{
+		static_cast<QSGFlatColorMaterial*>(node->material())->setColor(m_color);
+		node->markDirty(QSGNode::DirtyMaterial);
+
+		m_colorChanged = false;
+	}
+
+	return node;
+}
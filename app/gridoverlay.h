@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef GRIDOVERLAY_H
+#define GRIDOVERLAY_H
+
+#include <QColor>
+#include <QQuickItem>
+
+// Draws the face grid as scene graph geometry. Changing the counts or the size only rewrites the vertices.
+class GridOverlay : public QQuickItem
+{
+	Q_OBJECT
+	Q_PROPERTY(int horizontalCount READ horizontalCount WRITE setHorizontalCount NOTIFY horizontalCountChanged)
+	Q_PROPERTY(int verticalCount READ verticalCount WRITE setVerticalCount NOTIFY verticalCountChanged)
+	Q_PROPERTY(qreal lineWidth READ lineWidth WRITE setLineWidth NOTIFY lineWidthChanged)
+	Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+
+public:
+	explicit GridOverlay(QQuickItem* parent = nullptr);
+
+	int horizontalCount() const;
+	void setHorizontalCount(int horizontalCount);
+
+	int verticalCount() const;
+	void setVerticalCount(int verticalCount);
+
+	qreal lineWidth() const;
+	void setLineWidth(qreal lineWidth);
+
+	QColor color() const;
+	void setColor(const QColor& color);
+
+signals:
+	void horizontalCountChanged();
+	void verticalCountChanged();
+	void lineWidthChanged();
+	void colorChanged();
+
+protected:
+	QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+	void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+
+private:
+	int m_horizontalCount = 1;
+	int m_verticalCount = 1;
+
+	qreal m_lineWidth = 1.0;
+	QColor m_color = Qt::black;
+
+	bool m_colorChanged = true;
+};
+
+#endif // GRIDOVERLAY_H
@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <QApplication>
+#include <QQmlApplicationEngine>
+#include <QQuickStyle>
+#include <QQuickWindow>
+#include <QQmlContext>
+#include <QLoggingCategory>
+#include <QElapsedTimer>
+
+#include "templateexporter.h"
+#include "templateface.h"
+#include "imagecache.h"
+#include "templatecatalog.h"
+#include "mipimageprovider.h"
+#include "tilelistmodel.h"
+#include "tilethumbnailprovider.h"
+#include "gridoverlay.h"
+#include "frametimer.h"
+#include "exportcommandline.h"
+#include "logging.h"
+
+// The cache lives in the core library, which knows nothing about QML; the engine must not delete it.
+static QObject* imageCacheInstance(QQmlEngine* engine, QJSEngine* scriptEngine)
+{
+	Q_UNUSED(engine)
+	Q_UNUSED(scriptEngine)
+
+	QQmlEngine::setObjectOwnership(ImageCache::instance(), QQmlEngine::CppOwnership);
+
+	return ImageCache::instance();
+}
+
+int main(int argc, char* argv[])
+{
+	QElapsedTimer startup;
+	startup.start();
+
+	if (ExportCommandLine::isRequested(argc, argv))
+	{
+		QCoreApplication app(argc, argv);
+
+		app.setOrganizationName("Aruraune");
+		app.setOrganizationDomain("Aruraune");
+		app.setApplicationName("waifu2ugc");
+		app.setApplicationVersion("1.0-alpha");
+
+		return ExportCommandLine::run(app.arguments());
+	}
+
+	QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+
+	QApplication app(argc, argv);
+
+	app.setOrganizationName("Aruraune");
+	app.setOrganizationDomain("Aruraune");
+	app.setApplicationName("waifu2ugc");
+	app.setApplicationDisplayName("waifu2ugc");
+	app.setApplicationVersion("1.0-alpha");
+
+	QQuickStyle::setStyle("Default");
+
+	qmlRegisterSingletonType<TemplateExporter>("waifu2ugc", 1, 0, "TemplateExporter", &TemplateExporter::qmlInstance);
+	qmlRegisterSingletonType<ImageCache>("waifu2ugc", 1, 0, "ImageCache", &imageCacheInstance);
+	qmlRegisterSingletonType<TemplateCatalog>("waifu2ugc", 1, 0, "TemplateCatalog", &TemplateCatalog::qmlInstance);
+	qmlRegisterUncreatableType<TemplateFace>("waifu2ugc", 1, 0, "TemplateFace", "TemplateFace cannot be created in QML.");
+	qmlRegisterType<GridOverlay>("waifu2ugc", 1, 0, "GridOverlay");
+	qmlRegisterUncreatableType<TileListModel>("waifu2ugc", 1, 0, "TileListModel", "TileListModel cannot be created in QML.");
+
+	QQmlApplicationEngine engine;
+	engine.addImageProvider(ImageCache::providerName(), new MipImageProvider(ImageCache::instance()));
+	engine.addImageProvider(TileThumbnailProvider::providerName(), new TileThumbnailProvider);
+	engine.rootContext()->setContextProperty("legacyCanvasGrid", qEnvironmentVariableIntValue("WAIFU2UGC_CANVAS_GRID") != 0);
+
+	const QUrl url(QStringLiteral("qrc:/main.qml"));
+	QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
+					 &app, [url](QObject* obj, const QUrl& objUrl) {
+		if (!obj && url == objUrl)
+			QCoreApplication::exit(-1);
+	}, Qt::QueuedConnection);
+	engine.load(url);
+
+	qCInfo(lcPerf) << "QML loaded after" << startup.elapsed() << "ms";
+
+	if (!engine.rootObjects().isEmpty())
+	{
+		if (auto window = qobject_cast<QQuickWindow*>(engine.rootObjects().first()))
+		{
+			if (lcPerf().isInfoEnabled())
+			{
+				new FrameTimer(window);
+			}
+
+			auto connection = QSharedPointer<QMetaObject::Connection>::create();
+
+			*connection = QObject::connect(window, &QQuickWindow::frameSwapped, window, [startup, connection]() {
+				qCInfo(lcPerf) << "First frame after" << startup.elapsed() << "ms";
+				QObject::disconnect(*connection);
+			});
+		}
+	}
+
+	return app.exec();
+}
@@ -100,7 +100,7 @@ Window {
             onFinished: {
                 if (!TemplateExporter.canceled)
                 {
-                    statusAlert.message = qsTr("waifu2ugc finished exporting all images!")
+                    statusAlert.message = qsTr("waifu2ugc finished exporting all images!") + "\r\n\r\n" + TemplateExporter.exportReport
                     statusAlert.open()
                 }
             }
@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "mipimageprovider.h"
+#include "imagecache.h"
+#include "logging.h"
+
+#include <QElapsedTimer>
+
+MipImageProvider::MipImageProvider(ImageCache* cache) :
+	QQuickImageProvider(QQuickImageProvider::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading),
+	m_cache(cache)
+{
+}
+
+// Reports the size of the original image so QML can map painted coordinates back to source pixels,
+// but hands out the smallest mip level that still covers the requested size.
+QImage MipImageProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QSize sourceSize;
+	QUrl url = ImageCache::fromProviderId(id);
+	QImage image = m_cache->level(url, requestedSize, &sourceSize);
+
+	qCInfo(lcPerf) << "Served" << image.size() << "of" << url.toString() << "in" << timer.elapsed() << "ms";
+
+	if (size != nullptr)
+	{
+		*size = sourceSize;
+	}
+
+	return image;
+}
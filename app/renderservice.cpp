@@ -0,0 +1,239 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "renderservice.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+RenderService::RenderService(QObject* parent) :
+	QObject(parent),
+	m_server(new QLocalServer(this))
+{
+	// Each job composes on one of these threads and encodes on the global pool, which every job in the process shares,
+	// so composing is capped to half the cores and the encoders of all jobs together to all of them.
+	m_jobs.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+
+	connect(m_server, &QLocalServer::newConnection, this, &RenderService::newConnection);
+}
+
+bool RenderService::listen(const QString& name, QString* error)
+{
+	// A socket left behind by a crashed service is removed, one a running service still answers on is not.
+	QLocalSocket probe;
+	probe.connectToServer(name);
+
+	if (probe.waitForConnected(m_probeTimeout))
+	{
+		if (error != nullptr) *error = tr("Another service is already listening on '%1'.").arg(name);
+		return false;
+	}
+
+	QLocalServer::removeServer(name);
+
+	if (!m_server->listen(name))
+	{
+		if (error != nullptr) *error = tr("Failed to listen on '%1':\r\n%2").arg(name, m_server->errorString());
+		return false;
+	}
+
+	return true;
+}
+
+void RenderService::newConnection()
+{
+	while (QLocalSocket* socket = m_server->nextPendingConnection())
+	{
+		connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+		connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { clientDisconnected(socket); });
+		connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+	}
+}
+
+// Nobody is left to receive the tiles' progress or result, the client's jobs stop.
+void RenderService::clientDisconnected(QLocalSocket* socket)
+{
+	for (const auto& running : m_running)
+	{
+		if (running.client == socket)
+		{
+			running.token.cancel();
+		}
+	}
+}
+
+void RenderService::readRequests(QLocalSocket* socket)
+{
+	while (socket->canReadLine())
+	{
+		QByteArray line = socket->readLine().trimmed();
+
+		if (!line.isEmpty())
+		{
+			handleRequest(socket, line);
+		}
+	}
+}
+
+// {"id": ..., "job": {...}, "output": "dir", "shard": "i/N"} starts a job, {"cancel": id} stops one.
+void RenderService::handleRequest(QLocalSocket* socket, const QByteArray& line)
+{
+	QJsonParseError parseError;
+	const QJsonObject request = QJsonDocument::fromJson(line, &parseError).object();
+
+	if (parseError.error != QJsonParseError::NoError)
+	{
+		send(socket, { { "event", "error" }, { "message", tr("Invalid request: %1").arg(parseError.errorString()) } });
+		return;
+	}
+
+	if (request.contains("cancel"))
+	{
+		auto running = m_running.constFind(request.value("cancel").toString());
+
+		if (running != m_running.constEnd())
+		{
+			running->token.cancel();
+		}
+
+		return;
+	}
+
+	QString id = request.value("id").toString();
+	QString output = request.value("output").toString();
+
+	ExportJob job;
+	ShardSpec shard;
+	QString error;
+
+	if (id.isEmpty() || m_running.contains(id))
+	{
+		error = tr("Every job needs an id that is not already running.");
+	}
+	else if (output.isEmpty())
+	{
+		error = tr("The job has no output directory.");
+	}
+	else if (request.contains("shard") && !ShardSpec::parse(request.value("shard").toString(), shard))
+	{
+		error = tr("Invalid shard, expected i/N: %1").arg(request.value("shard").toString());
+	}
+	else
+	{
+		ExportJob::fromJson(request.value("job").toObject(), job, &error);
+	}
+
+	if (!error.isEmpty())
+	{
+		send(socket, { { "id", id }, { "event", "error" }, { "message", error } });
+		return;
+	}
+
+	CancellationToken token;
+	m_running[id] = Running(token, socket);
+
+	send(socket, { { "id", id }, { "event", "queued" } });
+
+	QPointer<QLocalSocket> client(socket);
+
+	QtConcurrent::run(&m_jobs, [this, client, id, job, output, shard, token]() {
+		runJob(client, id, job, output, shard, token);
+
+		QMetaObject::invokeMethod(this, [this, id]() { m_running.remove(id); }, Qt::QueuedConnection);
+	});
+}
+
+void RenderService::runJob(QPointer<QLocalSocket> socket, const QString& id, const ExportJob& job, const QString& output,
+						   const ShardSpec& shard, const CancellationToken& token)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QString error;
+	QSize tileSize = job.templateSize(&error);
+
+	if (!tileSize.isValid())
+	{
+		send(socket, { { "id", id }, { "event", "error" }, { "message", error } });
+		return;
+	}
+
+	ExportPlan plan = ExportPlan::compile(job.data(), tileSize);
+	QVector<int> selection = plan.select(shard);
+
+	send(socket, { { "id", id }, { "event", "started" }, { "tiles", selection.count() } });
+
+	int reported = -1;
+
+	TileRenderer::Callbacks callbacks;
+	callbacks.progress = [this, socket, id, &reported](qreal progress) {
+		int percent = int(progress * 100);
+
+		if (percent != reported)
+		{
+			reported = percent;
+			send(socket, { { "id", id }, { "event", "progress" }, { "progress", progress } });
+		}
+	};
+	callbacks.token = token;
+
+	TileRenderer::Report report;
+
+	if (!job.render(plan, selection, output, callbacks, report, &error))
+	{
+		send(socket, { { "id", id }, { "event", "error" }, { "message", error } });
+		return;
+	}
+
+	QJsonObject finished {
+		{ "id", id },
+		{ "event", token.isCanceled() ? "canceled" : "finished" },
+		{ "written", report.written },
+		{ "bytes", report.writtenBytes },
+		{ "seconds", timer.nsecsElapsed() / 1e9 },
+		{ "report", report.text(job.options().optimize) },
+		{ "pipeline", report.pipeline }
+	};
+
+	if (token.isCanceled())
+	{
+		finished["cancelLatency"] = report.cancelLatency / 1e9;
+	}
+
+	send(socket, finished);
+}
+
+// Callable from the job threads, the socket itself is only touched on the service thread.
+void RenderService::send(QPointer<QLocalSocket> socket, const QJsonObject& message)
+{
+	QMetaObject::invokeMethod(this, [socket, message]() {
+		if (!socket.isNull())
+		{
+			socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+		}
+	}, Qt::QueuedConnection);
+}
@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef RENDERSERVICE_H
+#define RENDERSERVICE_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+
+#include "cancellationtoken.h"
+#include "exportjob.h"
+#include "shardspec.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// Accepts jobs as one JSON object per line on a local socket and streams their progress back.
+// Decoded templates and faces stay in memory between jobs, so small jobs only pay for rendering.
+class RenderService : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit RenderService(QObject* parent = nullptr);
+
+	bool listen(const QString& name, QString* error = nullptr);
+
+private slots:
+	void newConnection();
+
+private:
+	void clientDisconnected(QLocalSocket* socket);
+	void readRequests(QLocalSocket* socket);
+	void handleRequest(QLocalSocket* socket, const QByteArray& line);
+
+	void runJob(QPointer<QLocalSocket> socket, const QString& id, const ExportJob& job, const QString& output,
+				const ShardSpec& shard, const CancellationToken& token);
+
+	void send(QPointer<QLocalSocket> socket, const QJsonObject& message);
+
+private:
+	QLocalServer* m_server;
+	QThreadPool m_jobs;
+
+	struct Running
+	{
+		Running() = default;
+		Running(const CancellationToken& token, QLocalSocket* client) : token(token), client(client)
+		{
+		}
+
+		CancellationToken token;
+		QLocalSocket* client = nullptr; // only compared, the job itself holds a guarded pointer
+	};
+
+	QHash<QString, Running> m_running;
+
+	static constexpr int m_probeTimeout = 200; // milliseconds
+};
+
+#endif // RENDERSERVICE_H
@@ -0,0 +1,341 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "templatecatalog.h"
+#include "imagecache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQmlEngine>
+#include <QDebug>
+
+Q_GLOBAL_STATIC(TemplateCatalog, globalTemplateCatalog)
+
+static QString readablePath(const QUrl& url)
+{
+	if (url.isLocalFile())
+	{
+		return url.toLocalFile();
+	}
+	else if (url.scheme() == "qrc")
+	{
+		return ":" + url.path();
+	}
+
+	return QString();
+}
+
+TemplateCatalog::TemplateCatalog(QObject* parent) : QAbstractListModel(parent)
+{
+	QString error;
+
+	if (!load(":/templates.json", &error))
+	{
+		qWarning() << error;
+	}
+}
+
+TemplateCatalog* TemplateCatalog::instance()
+{
+	return globalTemplateCatalog();
+}
+
+QObject* TemplateCatalog::qmlInstance(QQmlEngine* engine, QJSEngine* scriptEngine)
+{
+	Q_UNUSED(engine)
+	Q_UNUSED(scriptEngine)
+
+	QQmlEngine::setObjectOwnership(instance(), QQmlEngine::CppOwnership);
+
+	return instance();
+}
+
+// Everything the UI and the exporter need is parsed and checked here once, so switching layouts is just an index change.
+bool TemplateCatalog::load(const QString& path, QString* error)
+{
+	QFile file(path);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		if (error != nullptr) *error = tr("Failed to open the template catalog '%1'.").arg(path);
+		return false;
+	}
+
+	QJsonParseError parseError;
+	QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+	if (document.isNull())
+	{
+		if (error != nullptr) *error = tr("Invalid template catalog '%1': %2").arg(path, parseError.errorString());
+		return false;
+	}
+
+	QUrl base = path.startsWith(":") ? QUrl("qrc" + path) : QUrl::fromLocalFile(QFileInfo(path).absoluteFilePath());
+
+	QVector<TemplateLayout> layouts;
+	QHash<QUrl, QSize> imageSizes;
+
+	for (const auto& value : document.object().value("templates").toArray())
+	{
+		QJsonObject entry = value.toObject();
+
+		TemplateLayout layout;
+		layout.text() = entry["text"].toString();
+		layout.family() = entry["family"].toString();
+		layout.imageUrl() = base.resolved(QUrl(entry["image"].toString()));
+		layout.custom() = entry["custom"].toBool();
+
+		if (layout.text().isEmpty() || layout.imageUrl().isEmpty())
+		{
+			qWarning() << "Skipping template without a name or image in" << path;
+			continue;
+		}
+
+		// Only reads the header, the image itself is decoded by ImageCache when the layout is first used.
+		if (!imageSizes.contains(layout.imageUrl()))
+		{
+			QString imagePath = readablePath(layout.imageUrl());
+			imageSizes[layout.imageUrl()] = imagePath.isEmpty() ? QSize() : QImageReader(imagePath).size();
+		}
+
+		QRect imageRect(QPoint(0, 0), imageSizes[layout.imageUrl()]);
+
+		bool valid = true;
+		QJsonObject faces = entry["faces"].toObject();
+
+		for (auto it = faces.begin(); it != faces.end(); ++it)
+		{
+			FaceData::FaceIndex index = FaceData::indexFromName(it.key());
+			QJsonArray numbers = it.value().toArray();
+
+			if (index == FaceData::INVALID || numbers.count() != 4)
+			{
+				qWarning() << "Invalid face" << it.key() << "in template" << layout.text();
+				valid = false;
+				break;
+			}
+
+			QRect rect(numbers[0].toInt(), numbers[1].toInt(), numbers[2].toInt(), numbers[3].toInt());
+
+			if (rect.x() < 0 || rect.y() < 0 || rect.width() < 0 || rect.height() < 0 ||
+					(!rect.isEmpty() && imageRect.isValid() && !imageRect.contains(rect)))
+			{
+				qWarning() << "Face" << it.key() << "of template" << layout.text() << "is outside of its image";
+				valid = false;
+				break;
+			}
+
+			layout.faceRects()[index] = rect;
+			layout.bounds() |= rect;
+		}
+
+		// Masks outline the visible part of non-rectangular faces as points in fractions of the face rect.
+		QJsonObject masks = entry["masks"].toObject();
+
+		for (auto it = masks.begin(); valid && it != masks.end(); ++it)
+		{
+			FaceData::FaceIndex index = FaceData::indexFromName(it.key());
+			QPolygonF polygon;
+
+			for (const auto& point : it.value().toArray())
+			{
+				QJsonArray numbers = point.toArray();
+
+				if (numbers.count() == 2)
+				{
+					polygon.append(QPointF(numbers[0].toDouble(), numbers[1].toDouble()));
+				}
+			}
+
+			if (index == FaceData::INVALID || polygon.count() < 3 || !QRectF(0, 0, 1, 1).contains(polygon.boundingRect()))
+			{
+				qWarning() << "Invalid mask" << it.key() << "in template" << layout.text();
+				valid = false;
+				break;
+			}
+
+			layout.faceMasks()[index] = polygon;
+		}
+
+		if (valid)
+		{
+			layouts.append(layout);
+		}
+	}
+
+	if (layouts.isEmpty())
+	{
+		if (error != nullptr) *error = tr("The template catalog '%1' has no valid templates.").arg(path);
+		return false;
+	}
+
+	beginResetModel();
+	m_layouts = layouts;
+	m_currentIndex = std::min(m_currentIndex, m_layouts.count() - 1);
+	endResetModel();
+
+	emit countChanged();
+	emit currentIndexChanged();
+
+	return true;
+}
+
+int TemplateCatalog::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_layouts.count();
+}
+
+QVariant TemplateCatalog::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_layouts.count())
+	{
+		return QVariant();
+	}
+
+	const TemplateLayout& layout = m_layouts[index.row()];
+
+	switch (role)
+	{
+		case Qt::DisplayRole:
+		case TextRole:		return tr(layout.text().toUtf8().constData());
+		case FamilyRole:	return layout.family();
+		case ImageRole:		return layout.imageUrl();
+		case CustomRole:	return layout.custom();
+		default:			return QVariant();
+	}
+}
+
+QHash<int, QByteArray> TemplateCatalog::roleNames() const
+{
+	return {
+		{ TextRole, "text" },
+		{ FamilyRole, "family" },
+		{ ImageRole, "image" },
+		{ CustomRole, "custom" }
+	};
+}
+
+int TemplateCatalog::count() const
+{
+	return m_layouts.count();
+}
+
+int TemplateCatalog::currentIndex() const
+{
+	return m_currentIndex;
+}
+
+void TemplateCatalog::setCurrentIndex(int currentIndex)
+{
+	if (m_currentIndex != currentIndex && currentIndex >= 0 && currentIndex < m_layouts.count())
+	{
+		m_currentIndex = currentIndex;
+		emit currentIndexChanged();
+	}
+}
+
+QString TemplateCatalog::currentText() const
+{
+	return tr(currentLayout().text().toUtf8().constData());
+}
+
+QUrl TemplateCatalog::currentImage() const
+{
+	return currentLayout().imageUrl();
+}
+
+bool TemplateCatalog::currentCustom() const
+{
+	return currentLayout().custom();
+}
+
+int TemplateCatalog::currentVariantCount() const
+{
+	return variants(m_currentIndex).count();
+}
+
+const TemplateLayout& TemplateCatalog::layout(int index) const
+{
+	static const TemplateLayout invalid;
+
+	return index >= 0 && index < m_layouts.count() ? m_layouts[index] : invalid;
+}
+
+const TemplateLayout& TemplateCatalog::currentLayout() const
+{
+	return layout(m_currentIndex);
+}
+
+// The layouts of the same family, in catalog order, which can be exported together from one set of faces.
+QVector<int> TemplateCatalog::variants(int index) const
+{
+	QVector<int> indices;
+	const TemplateLayout& target = layout(index);
+
+	if (target.custom() || target.family().isEmpty())
+	{
+		return indices;
+	}
+
+	for (int i = 0; i < m_layouts.count(); ++i)
+	{
+		if (!m_layouts[i].custom() && m_layouts[i].family() == target.family())
+		{
+			indices.append(i);
+		}
+	}
+
+	return indices;
+}
+
+// Layouts sharing an image share the decoded pixels as well.
+QImage TemplateCatalog::templateImage(int index, QString* error) const
+{
+	return ImageCache::instance()->image(layout(index).imageUrl(), error);
+}
+
+QVariant TemplateCatalog::faceRect(int index, const QString& face) const
+{
+	const TemplateLayout& target = layout(index);
+	FaceData::FaceIndex faceIndex = FaceData::indexFromName(face);
+
+	return target.hasFace(faceIndex) ? QVariant(target.faceRect(faceIndex)) : QVariant();
+}
+
+int TemplateCatalog::find(const QString& text) const
+{
+	for (int i = 0; i < m_layouts.count(); ++i)
+	{
+		if (m_layouts[i].text() == text)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TEMPLATECATALOG_H
+#define TEMPLATECATALOG_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QImage>
+#include <QUrl>
+
+#include "templatelayout.h"
+
+class QQmlEngine;
+class QJSEngine;
+
+class TemplateCatalog : public QAbstractListModel
+{
+	Q_OBJECT
+	Q_PROPERTY(int count READ count NOTIFY countChanged)
+	Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY currentIndexChanged)
+	Q_PROPERTY(QString currentText READ currentText NOTIFY currentIndexChanged)
+	Q_PROPERTY(QUrl currentImage READ currentImage NOTIFY currentIndexChanged)
+	Q_PROPERTY(bool currentCustom READ currentCustom NOTIFY currentIndexChanged)
+	Q_PROPERTY(int currentVariantCount READ currentVariantCount NOTIFY currentIndexChanged)
+
+public:
+	enum Roles {
+		TextRole = Qt::UserRole + 1,
+		FamilyRole,
+		ImageRole,
+		CustomRole
+	};
+
+	explicit TemplateCatalog(QObject* parent = nullptr);
+
+	static TemplateCatalog* instance();
+	static QObject* qmlInstance(QQmlEngine* engine, QJSEngine* scriptEngine);
+
+	bool load(const QString& path, QString* error = nullptr);
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QHash<int, QByteArray> roleNames() const override;
+
+	int count() const;
+
+	int currentIndex() const;
+	void setCurrentIndex(int currentIndex);
+
+	QString currentText() const;
+	QUrl currentImage() const;
+	bool currentCustom() const;
+	int currentVariantCount() const;
+
+	const TemplateLayout& layout(int index) const;
+	const TemplateLayout& currentLayout() const;
+
+	QVector<int> variants(int index) const;
+
+	QImage templateImage(int index, QString* error = nullptr) const;
+
+	Q_INVOKABLE QVariant faceRect(int index, const QString& face) const;
+	Q_INVOKABLE int find(const QString& text) const;
+
+signals:
+	void countChanged();
+	void currentIndexChanged();
+
+private:
+	QVector<TemplateLayout> m_layouts;
+
+	int m_currentIndex = 0;
+};
+
+#endif // TEMPLATECATALOG_H
@@ -0,0 +1,1081 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "templateexporter.h"
+#include "templateface.h"
+#include "imagecache.h"
+#include "remotefetcher.h"
+#include "exportjob.h"
+#include "tilerenderer.h"
+#include "templatecatalog.h"
+#include "logging.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QImage>
+#include <QQmlEngine>
+#include <QBuffer>
+#include <QDir>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSettings>
+
+TemplateExporter::TemplateExporter(QObject* parent) :
+	QObject(parent),
+	m_watcher(new QFutureWatcher<void>(this)),
+	m_inputWatcher(new ExportWatcher(this)),
+	m_frontFace(new TemplateFace("front", FaceData::FRONT, tr("Front"), this)),
+	m_topFace(new TemplateFace("top", FaceData::TOP, tr("Top"), this)),
+	m_rightFace(new TemplateFace("right", FaceData::RIGHT, tr("Right"), this)),
+	m_backFace(new TemplateFace("back", FaceData::BACK, tr("Back"), this)),
+	m_bottomFace(new TemplateFace("bottom", FaceData::BOTTOM, tr("Bottom"), this)),
+	m_leftFace(new TemplateFace("left", FaceData::LEFT, tr("Left"), this)),
+	m_tiles(new TileListModel(this)),
+	m_sessionTimer(new QTimer(this))
+{
+	connect(m_watcher, &QFutureWatcher<void>::finished, this, &TemplateExporter::processFinished);
+	connect(RemoteFetcher::instance(), &RemoteFetcher::fetched, this, &TemplateExporter::remoteImageFetched);
+	connect(m_inputWatcher, &ExportWatcher::changed, this, &TemplateExporter::inputsChanged);
+	connect(m_inputWatcher, &ExportWatcher::missing, this, [this](const QString& path) {
+		// Not through emitError(), which would fail an export running meanwhile.
+		QString message = tr("A watched input was removed and did not come back:\r\n%1").arg(path);
+
+		setErrorMessage(message);
+		emit error(message);
+	});
+
+	m_sessionTimer->setSingleShot(true);
+	m_sessionTimer->setInterval(m_sessionDelay);
+
+	connect(m_sessionTimer, &QTimer::timeout, this, &TemplateExporter::saveSession);
+	connect(this, &TemplateExporter::urlChanged, m_sessionTimer, QOverload<>::of(&QTimer::start));
+	connect(TemplateCatalog::instance(), &TemplateCatalog::currentIndexChanged, m_sessionTimer, QOverload<>::of(&QTimer::start));
+
+	for (TemplateFace* face : { m_frontFace, m_topFace, m_rightFace, m_backFace, m_bottomFace, m_leftFace })
+	{
+		connect(face, &TemplateFace::changed, m_sessionTimer, QOverload<>::of(&QTimer::start));
+	}
+}
+
+// Edits made just before quitting are still saved.
+TemplateExporter::~TemplateExporter()
+{
+	if (m_sessionTimer->isActive())
+	{
+		saveSession();
+	}
+}
+
+QUrl TemplateExporter::templateUrl() const {
+	return m_data.templateUrl();
+}
+
+void TemplateExporter::setTemplateUrl(const QUrl& url)
+{
+	if (m_data.templateUrl() != url)
+	{
+		m_data.templateUrl() = url;
+		emit urlChanged();
+	}
+}
+
+bool TemplateExporter::canceled() const {
+	return m_token.isCanceled();
+}
+
+void TemplateExporter::setCanceled(bool canceled) {
+	if (m_token.isCanceled() != canceled)
+	{
+		if (canceled)
+		{
+			m_token.cancel();
+		}
+		else
+		{
+			m_token = CancellationToken();
+		}
+
+		emit canceledChanged();
+	}
+}
+
+void TemplateExporter::emitAborted()
+{
+	emit aborted();
+}
+
+bool TemplateExporter::busy() const {
+	return m_busy;
+}
+
+void TemplateExporter::setBusy(bool busy) {
+	if (m_busy != busy)
+	{
+		m_busy = busy;
+		emit busyChanged();
+	}
+}
+
+qreal TemplateExporter::progress() const {
+	return m_progress;
+}
+
+void TemplateExporter::setProgress(qreal progress) {
+	if (std::abs(m_progress - progress) > 0.005)
+	{
+		m_progress = progress;
+		emit progressChanged();
+	}
+}
+
+QString TemplateExporter::errorMessage() const {
+	return m_errorMessage;
+}
+
+QString TemplateExporter::statusMessage() const {
+	return m_statusMessage;
+}
+
+void TemplateExporter::setErrorMessage(const QString& message) {
+	if (m_errorMessage != message)
+	{
+		m_errorMessage = message;
+		emit errorMessageChanged();
+	}
+}
+
+void TemplateExporter::emitError(const QString& message)
+{
+	// The error is then the export's only terminal signal, see processFinished().
+	if (m_busy)
+	{
+		m_failed = true;
+	}
+
+	setErrorMessage(message);
+	emit error(message);
+}
+
+void TemplateExporter::setStatusMessage(const QString &message) {
+	if (m_statusMessage != message)
+	{
+		m_statusMessage = message;
+		emit statusMessageChanged();
+	}
+}
+
+QString TemplateExporter::exportReport() const {
+	return m_exportReport;
+}
+
+void TemplateExporter::setExportReport(const QString& report) {
+	if (m_exportReport != report)
+	{
+		m_exportReport = report;
+		emit exportReportChanged();
+	}
+}
+
+bool TemplateExporter::optimizeOutput() const {
+	return m_optimizeOutput;
+}
+
+void TemplateExporter::setOptimizeOutput(bool optimizeOutput) {
+	if (m_optimizeOutput != optimizeOutput)
+	{
+		m_optimizeOutput = optimizeOutput;
+		emit optimizeOutputChanged();
+	}
+}
+
+bool TemplateExporter::quantizeOutput() const {
+	return m_quantizeOutput;
+}
+
+void TemplateExporter::setQuantizeOutput(bool quantizeOutput) {
+	if (m_quantizeOutput != quantizeOutput)
+	{
+		m_quantizeOutput = quantizeOutput;
+		emit quantizeOutputChanged();
+	}
+}
+
+bool TemplateExporter::watching() const {
+	return m_watching;
+}
+
+void TemplateExporter::setWatching(bool watching) {
+	if (m_watching != watching)
+	{
+		m_watching = watching;
+
+		if (!m_watching)
+		{
+			m_inputWatcher->clear();
+			m_pendingChanges.clear();
+		}
+		else if (!m_busy && !m_lastInputs.images.isEmpty())
+		{
+			m_inputWatcher->watch(m_lastSources);
+		}
+
+		emit watchingChanged();
+	}
+}
+
+bool TemplateExporter::exportVariants() const {
+	return m_exportVariants;
+}
+
+void TemplateExporter::setExportVariants(bool exportVariants) {
+	if (m_exportVariants != exportVariants)
+	{
+		m_exportVariants = exportVariants;
+		emit exportVariantsChanged();
+	}
+}
+
+TileListModel* TemplateExporter::tiles() const
+{
+	return m_tiles;
+}
+
+TemplateFace* TemplateExporter::frontFace() const
+{
+	return m_frontFace;
+}
+
+TemplateFace* TemplateExporter::topFace() const
+{
+	return m_topFace;
+}
+
+TemplateFace* TemplateExporter::rightFace() const
+{
+	return m_rightFace;
+}
+
+TemplateFace* TemplateExporter::backFace() const
+{
+	return m_backFace;
+}
+
+TemplateFace* TemplateExporter::bottomFace() const
+{
+	return m_bottomFace;
+}
+
+TemplateFace* TemplateExporter::leftFace() const
+{
+	return m_leftFace;
+}
+
+TemplateData TemplateExporter::copyData() const
+{
+	return m_data;
+}
+
+ExportData TemplateExporter::exportData() const
+{
+	ExportData data;
+
+	data.source() = copyData();
+
+	data.front() = m_frontFace->copyData();
+	data.top() = m_topFace->copyData();
+	data.right() = m_rightFace->copyData();
+	data.back() = m_backFace->copyData();
+	data.bottom() = m_bottomFace->copyData();
+	data.left() = m_leftFace->copyData();
+
+	// Non-rectangular faces take their masks from the catalog layout the template came from.
+	const TemplateLayout& layout = TemplateCatalog::instance()->currentLayout();
+
+	if (!layout.custom() && layout.imageUrl() == m_data.templateUrl())
+	{
+		for (auto it = layout.faceMasks().begin(); it != layout.faceMasks().end(); ++it)
+		{
+			data.face(it.key()).mask() = it.value();
+		}
+	}
+
+	return data;
+}
+
+QObject* TemplateExporter::qmlInstance(QQmlEngine* engine, QJSEngine* scriptEngine)
+{
+	Q_UNUSED(engine)
+	Q_UNUSED(scriptEngine)
+
+	return new TemplateExporter;
+}
+
+QString TemplateExporter::supportedImageTypes() const
+{
+	return "*." + QImageReader::supportedImageFormats().join(" *.");
+}
+
+QUrl TemplateExporter::alternativeResolve(const QString& path) const
+{
+	return QDir::isAbsolutePath(path) ? QUrl::fromLocalFile(path) : QUrl::fromLocalFile(QFileInfo(QDir::home(), path).absoluteFilePath());
+}
+
+bool TemplateExporter::directoryExists(const QUrl& url) const
+{	
+	return QDir(url.toLocalFile()).exists();
+}
+
+// Jobs carry everything the command line needs to repeat this export, see ExportCommandLine.
+bool TemplateExporter::saveJob(const QUrl& file)
+{
+	ExportJob job;
+	job.data() = exportData();
+	job.options().optimize = m_optimizeOutput;
+	job.options().quantize = m_quantizeOutput;
+
+	QSaveFile output(file.toLocalFile());
+
+	if (!output.open(QIODevice::WriteOnly) || output.write(QJsonDocument(job.toJson()).toJson()) < 0 || !output.commit())
+	{
+		emitError(tr("Failed to save job to:\r\n%1\r\n%2").arg(file.toLocalFile(), output.errorString()));
+		return false;
+	}
+
+	return true;
+}
+
+// The fit and crop rects are left out, the face views derive them again from the image once it is shown.
+void TemplateExporter::saveSession()
+{
+	m_sessionTimer->stop();
+
+	const TemplateCatalog* catalog = TemplateCatalog::instance();
+
+	QSettings settings;
+	settings.beginGroup("session");
+	settings.setValue("layout", catalog->currentText());
+	settings.setValue("customTemplate", m_data.templateUrl() != catalog->currentImage() ? m_data.templateUrl() : QUrl());
+
+	for (TemplateFace* face : { m_frontFace, m_topFace, m_rightFace, m_backFace, m_bottomFace, m_leftFace })
+	{
+		FaceData data = face->copyData();
+
+		settings.beginGroup(face->face());
+		settings.setValue("faceEnabled", data.enabled());
+		settings.setValue("faceRect", data.faceRect());
+		settings.setValue("horizontalCount", data.horizontalCount());
+		settings.setValue("verticalCount", data.verticalCount());
+		settings.setValue("faceImage", data.faceImageUrl());
+		settings.setValue("resizeSource", data.resizeSource());
+		settings.setValue("preserveAspectRatio", data.preserveAspectRatio());
+		settings.setValue("aspectRatioIndex", data.aspectRatioAction());
+		settings.endGroup();
+	}
+}
+
+QVariantMap TemplateExporter::session() const
+{
+	QVariantMap session;
+
+	QSettings settings;
+	settings.beginGroup("session");
+
+	if (!settings.contains("layout"))
+	{
+		return session;
+	}
+
+	session["layout"] = settings.value("layout");
+	session["customTemplate"] = settings.value("customTemplate").toUrl();
+
+	for (const QString& face : settings.childGroups())
+	{
+		if (FaceData::indexFromName(face) == FaceData::INVALID)
+		{
+			continue;
+		}
+
+		QVariantMap values;
+
+		settings.beginGroup(face);
+		values["faceEnabled"] = settings.value("faceEnabled").toBool();
+		values["faceRect"] = settings.value("faceRect").toRect();
+		values["horizontalCount"] = settings.value("horizontalCount", 1).toInt();
+		values["verticalCount"] = settings.value("verticalCount", 1).toInt();
+		values["faceImage"] = settings.value("faceImage").toUrl();
+		values["resizeSource"] = settings.value("resizeSource").toBool();
+		values["preserveAspectRatio"] = settings.value("preserveAspectRatio").toBool();
+		values["aspectRatioIndex"] = settings.value("aspectRatioIndex").toInt();
+		settings.endGroup();
+
+		session[face] = values;
+	}
+
+	return session;
+}
+
+void TemplateExporter::exportToDirectory(const QUrl& directory)
+{
+	exportToDirectories({ directory });
+}
+
+// The tiles are rendered once and written to every directory, the first one is where the gallery looks for them.
+void TemplateExporter::exportToDirectories(const QList<QUrl>& directories)
+{
+	if (m_busy)
+	{
+		emitError(tr("waifu2ugc is already generating the files, please wait."));
+		return;
+	}
+
+	QStringList paths;
+
+	for (const QUrl& directory : directories)
+	{
+		if (!directory.isLocalFile())
+		{
+			emitError(tr("The destination must be a local path."));
+			return;
+		}
+
+		if (!QDir(directory.toLocalFile()).exists())
+		{
+			emitError(tr("Invalid output destination."));
+			return;
+		}
+
+		if (!paths.contains(directory.toLocalFile()))
+		{
+			paths.append(directory.toLocalFile());
+		}
+	}
+
+	if (paths.isEmpty())
+	{
+		emitError(tr("Invalid output destination."));
+		return;
+	}
+
+	m_token = CancellationToken();
+	m_failed = false;
+
+	setBusy(true);
+
+	setStatusMessage(tr("Preparing images..."));
+	setExportReport("");
+	setProgress(0);
+
+	m_exportUrl = directories.first();
+	m_exportDirectories = paths;
+	preloadImages();
+}
+
+void TemplateExporter::cancel()
+{
+	setCanceled(true);
+
+	// Preloading waits for downloads rather than for the worker, it stops right here.
+	if (m_busy && !m_watcher->isRunning())
+	{
+		for (auto it = m_loaderReady.begin(); it != m_loaderReady.end(); ++it)
+		{
+			if (!it.value())
+			{
+				RemoteFetcher::instance()->abort(it.key());
+			}
+		}
+
+		checkLoaders();
+	}
+}
+
+// The worker's status and progress, the progress mapped onto the part of the bar its stage owns.
+TileRenderer::Callbacks TemplateExporter::workerCallbacks(TemplateExporter* exporter, qreal start, qreal total, const CancellationToken& token)
+{
+	TileRenderer::Callbacks callbacks;
+	callbacks.status = [exporter](const QString& message) {
+		QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, message));
+	};
+	callbacks.progress = [exporter, start, total](qreal progress) {
+		QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, start + progress * total));
+	};
+	callbacks.token = token;
+
+	return callbacks;
+}
+
+// Runs on the worker: the downloads preloading collected are decoded here rather than on the interface thread,
+// into the ImageCache the jobs load from.
+bool TemplateExporter::decodeFetched(TemplateExporter* exporter, const QHash<QUrl, QByteArray>& fetched, const CancellationToken& token)
+{
+	if (!fetched.isEmpty())
+	{
+		QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Decoding downloaded images...")));
+	}
+
+	for (auto it = fetched.constBegin(); it != fetched.constEnd(); ++it)
+	{
+		if (token.isCanceled())
+		{
+			QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Canceled while preloading images.")));
+			return false;
+		}
+
+		QByteArray data = it.value();
+		QBuffer buffer(&data);
+		QImageReader reader(&buffer);
+		QImage image;
+
+		if (!reader.read(&image))
+		{
+			QMetaObject::invokeMethod(exporter, "emitError", Qt::QueuedConnection,
+									  Q_ARG(QString, tr("Error loading image from:\r\n%1").arg(it.key().toString())));
+			return false;
+		}
+
+		ImageCache::instance()->insert(it.key(), image);
+	}
+
+	return true;
+}
+
+// Runs on the worker: decodes and processes the given inputs into prepared, replacing what it held for them.
+bool TemplateExporter::prepareImages(TemplateExporter* exporter, const QStringList& keys, Prepared& prepared, CancellationToken token)
+{
+	if (!decodeFetched(exporter, prepared.fetched, token))
+	{
+		return false;
+	}
+
+	QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, m_imageProcessingStart));
+
+	QString error;
+
+	if (!prepared.job.loadImages(prepared.inputs, keys, workerCallbacks(exporter, m_imageProcessingStart, m_imageProcessingTotal, token), &error))
+	{
+		if (token.isCanceled())
+		{
+			QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Canceled while processing images.")));
+		}
+		else
+		{
+			QMetaObject::invokeMethod(exporter, "emitError", Qt::QueuedConnection, Q_ARG(QString, error));
+		}
+
+		return false;
+	}
+
+	prepared.complete = true;
+
+	return true;
+}
+
+void TemplateExporter::startProcessing() {
+	if (m_watcher->isRunning())
+	{
+		emitError(tr("Invalid state: Export process is already running."));
+	}
+	else
+	{
+		if (m_exportVariants && startVariants())
+		{
+			return;
+		}
+
+		setStatusMessage(tr("Copying state..."));
+
+		QSharedPointer<Prepared> prepared(new Prepared);
+		prepared->job.data() = exportData();
+		prepared->job.options().optimize = m_optimizeOutput;
+		prepared->job.options().quantize = m_quantizeOutput;
+		prepared->sources = m_sources;
+		prepared->fetched = m_fetched;
+
+		m_prepared = prepared;
+		m_fetched.clear();
+		m_pendingChanges.clear();
+
+		QStringList keys = m_sources.keys();
+		QStringList directories = m_exportDirectories;
+
+		CancellationToken token = m_token;
+
+		// Decoding and processing go to the worker too, so the interface stays free to cancel them.
+		m_watcher->setFuture(QtConcurrent::run([this, prepared, keys, directories, token]() {
+			if (prepareImages(this, keys, *prepared, token))
+			{
+				process(this, prepared->job, prepared->inputs, directories, {}, token);
+			}
+		}));
+	}
+}
+
+void TemplateExporter::processFinished() {
+	setStatusMessage("");
+	setProgress(0);
+
+	setBusy(false);
+
+	if (!m_prepared.isNull() && m_prepared->complete)
+	{
+		m_lastJob = m_prepared->job;
+		m_lastSources = m_prepared->sources;
+		m_lastInputs = m_prepared->inputs;
+	}
+
+	m_prepared.reset();
+
+	if (!m_lastInputs.images.isEmpty())
+	{
+		m_tiles->load(m_exportUrl.toLocalFile(), ExportPlan::compile(m_lastJob.data(), m_lastInputs.images["template"].size()));
+	}
+
+	// Exactly one of error, aborted and finished ends an export; an error was emitted by the worker already.
+	if (!m_failed && m_token.isCanceled())
+	{
+		emitAborted();
+	}
+	else if (!m_failed)
+	{
+		emit finished();
+	}
+
+	if (m_watching && !m_failed && !m_token.isCanceled())
+	{
+		m_inputWatcher->watch(m_lastSources);
+
+		if (!m_pendingChanges.isEmpty())
+		{
+			QStringList keys = m_pendingChanges;
+			m_pendingChanges.clear();
+
+			reexport(keys);
+		}
+	}
+}
+
+void TemplateExporter::inputsChanged(const QStringList& keys)
+{
+	if (m_busy)
+	{
+		m_pendingChanges.append(keys);
+	}
+	else
+	{
+		reexport(keys);
+	}
+}
+
+// Decodes only the changed inputs again and rewrites the tiles showing them; a new template redoes everything.
+void TemplateExporter::reexport(const QStringList& keys)
+{
+	if (m_lastInputs.images.isEmpty())
+	{
+		return;
+	}
+
+	m_token = CancellationToken();
+	m_failed = false;
+
+	setBusy(true);
+	setStatusMessage(tr("Reloading changed images..."));
+	setExportReport("");
+	setProgress(m_imageProcessingStart);
+
+	QSharedPointer<Prepared> prepared(new Prepared);
+	prepared->job = m_lastJob;
+	prepared->sources = m_lastSources;
+	prepared->inputs = m_lastInputs;
+
+	m_prepared = prepared;
+
+	QStringList changed = QSet<QString>::fromList(keys).toList();
+	QSet<FaceData::FaceIndex> faces;
+	QSet<QUrl> urls;
+
+	for (const auto& key : changed)
+	{
+		FaceData::FaceIndex index = FaceData::indexFromName(key);
+
+		urls.insert(m_lastSources.value(key));
+
+		if (index != FaceData::INVALID)
+		{
+			faces.insert(index);
+		}
+	}
+
+	// A new template changes every tile.
+	if (faces.count() < changed.count())
+	{
+		faces.clear();
+	}
+
+	QStringList directories = m_exportDirectories;
+
+	CancellationToken token = m_token;
+
+	m_watcher->setFuture(QtConcurrent::run([this, prepared, changed, urls, faces, directories, token]() {
+		for (const auto& url : urls)
+		{
+			ImageCache::instance()->remove(url);
+		}
+
+		if (prepareImages(this, changed, *prepared, token))
+		{
+			process(this, prepared->job, prepared->inputs, directories, faces, token);
+		}
+	}));
+}
+
+// Every stage is expected to notice a cancel within this long, see CancellationToken.
+static constexpr qint64 cancelLatencyBudget = 50 * 1000 * 1000; // nanoseconds
+
+static void reportCancelLatency(qint64 latency)
+{
+	if (latency > cancelLatencyBudget)
+	{
+		qCWarning(lcPerf, "Cancel took %.1f ms to stop the export", latency / 1e6);
+	}
+	else
+	{
+		qCInfo(lcPerf, "Cancel took %.1f ms to stop the export", latency / 1e6);
+	}
+}
+
+void TemplateExporter::process(TemplateExporter* exporter, const ExportJob& job, const ExportJob::Inputs& inputs,
+							   const QStringList& directories, const QSet<FaceData::FaceIndex>& faces, const CancellationToken& token)
+{
+	QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Worker started. Calculating...")));
+	QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, m_exportStart));
+
+	ExportPlan plan = ExportPlan::compile(job.data(), inputs.images.value("template").size());
+	QVector<int> selection = faces.isEmpty() ? plan.select(ShardSpec()) : plan.select(faces);
+
+	TileRenderer::Report report;
+	QString error;
+
+	bool rendered = job.render(plan, selection, inputs, directories, workerCallbacks(exporter, m_exportStart, m_exportTotal, token), report, &error);
+
+	if (report.written > 0 || report.failed > 0)
+	{
+		qCInfo(lcPerf) << "Export pipeline:" << report.pipeline;
+
+		QMetaObject::invokeMethod(exporter, "setExportReport", Qt::QueuedConnection, Q_ARG(QString, report.text(job.options().optimize)));
+	}
+
+	if (!rendered)
+	{
+		QMetaObject::invokeMethod(exporter, "emitError", Qt::QueuedConnection, Q_ARG(QString, error));
+		return;
+	}
+
+	if (!token.isCanceled())
+	{
+		QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Completed!")));
+		QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, m_exportStart + m_exportTotal));
+	}
+	else
+	{
+		reportCancelLatency(report.cancelLatency);
+
+		QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Canceled while exporting.")));
+	}
+}
+
+// Derives one export per layout of the current family from the same faces, each going to a folder named after it.
+bool TemplateExporter::startVariants()
+{
+	const TemplateCatalog* catalog = TemplateCatalog::instance();
+	QVector<int> indices = catalog->variants(catalog->currentIndex());
+
+	if (indices.count() < 2 || catalog->currentLayout().imageUrl() != m_data.templateUrl())
+	{
+		return false;
+	}
+
+	setStatusMessage(tr("Copying state..."));
+
+	ExportData base = exportData();
+
+	QVector<ExportJob> jobs;
+	QStringList names;
+
+	for (int index : indices)
+	{
+		const TemplateLayout& layout = catalog->layout(index);
+
+		ExportJob job;
+		job.data() = base;
+		job.data().source().templateUrl() = layout.imageUrl();
+		job.options().optimize = m_optimizeOutput;
+		job.options().quantize = m_quantizeOutput;
+
+		for (auto it = base.faces().begin(); it != base.faces().end(); ++it)
+		{
+			FaceData& face = job.data().face(it.key());
+
+			face.faceRect() = layout.faceRect(it.key());
+			face.mask() = layout.faceMask(it.key());
+			face.enabled() = face.enabled() && !face.faceRect().isEmpty();
+		}
+
+		QString name = layout.text();
+		name.replace(QRegularExpression("[^\\w .()-]"), "_");
+
+		jobs.append(job);
+		names.append(name);
+	}
+
+	// Watch mode and the tile gallery follow single exports only.
+	m_lastInputs = ExportJob::Inputs();
+	m_lastSources.clear();
+	m_pendingChanges.clear();
+	m_inputWatcher->clear();
+	m_tiles->clear();
+
+	QHash<QUrl, QByteArray> fetched = m_fetched;
+	QStringList directories = m_exportDirectories;
+
+	m_fetched.clear();
+
+	setStatusMessage(tr("Starting..."));
+
+	CancellationToken token = m_token;
+
+	m_watcher->setFuture(QtConcurrent::run([this, jobs, names, fetched, directories, token]() {
+		if (decodeFetched(this, fetched, token))
+		{
+			processVariants(this, jobs, names, directories, token);
+		}
+	}));
+
+	return true;
+}
+
+void TemplateExporter::processVariants(TemplateExporter* exporter, const QVector<ExportJob>& jobs, const QStringList& names,
+									   const QStringList& directories, const CancellationToken& token)
+{
+	auto fail = [exporter](const QString& message) {
+		QMetaObject::invokeMethod(exporter, "emitError", Qt::QueuedConnection, Q_ARG(QString, message));
+	};
+
+	QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, m_imageProcessingStart));
+
+	QVector<ExportJob::Inputs> inputs;
+	QString error;
+
+	if (!ExportJob::loadVariantImages(jobs, inputs, workerCallbacks(exporter, m_imageProcessingStart, m_imageProcessingTotal, token), &error))
+	{
+		if (token.isCanceled())
+		{
+			reportCancelLatency(token.sinceCancel());
+
+			QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Canceled while processing images.")));
+		}
+		else
+		{
+			fail(error);
+		}
+
+		return;
+	}
+
+	QVector<ExportPlan> plans;
+	ExportPlan::Calibration calibration = ExportPlan::Calibration::load(jobs.first().options().optimize);
+	ExportPlan::Estimate total;
+
+	for (int i = 0; i < jobs.count(); ++i)
+	{
+		plans.append(ExportPlan::compile(jobs[i].data(), inputs[i].images.value("template").size()));
+		total.outputBytes += plans.last().estimate(plans.last().select(ShardSpec()), calibration).outputBytes;
+	}
+
+	// The variants go to the same disks, which need room for all of them.
+	if (!ExportJob::prepareDirectories(directories, total, &error))
+	{
+		fail(error);
+		return;
+	}
+
+	QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, m_exportStart));
+
+	QVector<TileRenderer::Report> reports(jobs.count());
+	QStringList errors;
+
+	// One variant at a time: each render already spreads its tiles over the encoder and writer pools it sizes for
+	// the whole machine, rendering them side by side would only nest those pools inside this one.
+	for (int i = 0; i < jobs.count() && !token.isCanceled(); ++i)
+	{
+		QStringList variantDirectories;
+
+		for (const QString& directory : directories)
+		{
+			variantDirectories.append(QDir(directory).filePath(names[i]));
+		}
+
+		qreal share = m_exportTotal / jobs.count();
+		QString name = names[i];
+
+		TileRenderer::Callbacks callbacks = workerCallbacks(exporter, m_exportStart + i * share, share, token);
+		callbacks.status = [exporter, name](const QString& message) {
+			QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, name + ": " + message));
+		};
+
+		if (!jobs[i].render(plans[i], plans[i].select(ShardSpec()), inputs[i], variantDirectories, callbacks, reports[i], &error))
+		{
+			errors.append(error);
+		}
+	}
+
+	QStringList lines;
+
+	for (int i = 0; i < jobs.count(); ++i)
+	{
+		lines.append(QString("%1: %2").arg(names[i], reports[i].text(jobs[i].options().optimize)));
+	}
+
+	QMetaObject::invokeMethod(exporter, "setExportReport", Qt::QueuedConnection, Q_ARG(QString, lines.join("\r\n")));
+
+	if (!errors.isEmpty())
+	{
+		QMetaObject::invokeMethod(exporter, "emitError", Qt::QueuedConnection, Q_ARG(QString, errors.join("\r\n\r\n")));
+	}
+
+	if (!token.isCanceled())
+	{
+		QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Completed!")));
+		QMetaObject::invokeMethod(exporter, "setProgress", Qt::QueuedConnection, Q_ARG(qreal, m_exportStart + m_exportTotal));
+	}
+	else
+	{
+		reportCancelLatency(token.sinceCancel());
+
+		QMetaObject::invokeMethod(exporter, "setStatusMessage", Qt::QueuedConnection, Q_ARG(QString, tr("Canceled while exporting.")));
+	}
+}
+
+// Local images are decoded when processing starts, only remote ones have to be waited for.
+void TemplateExporter::preloadImages() {
+	setStatusMessage(tr("Preloading images..."));
+	setProgress(m_preloadingStart);
+
+	QHash<QString, QUrl> urls {
+		{ "template",  m_data.templateUrl() },
+
+		{ m_frontFace->face() , m_frontFace->faceImageUrl()  },
+		{ m_topFace->face()   , m_topFace->faceImageUrl()    },
+		{ m_rightFace->face() , m_rightFace->faceImageUrl()  },
+		{ m_backFace->face()  , m_backFace->faceImageUrl()   },
+		{ m_bottomFace->face(), m_bottomFace->faceImageUrl() },
+		{ m_leftFace->face()  , m_leftFace->faceImageUrl()   }
+	};
+
+	QHash<QString, bool> enabled {
+		{ "template",  true },
+
+		{ m_frontFace->face() , m_frontFace->faceEnabled()  },
+		{ m_topFace->face()   , m_topFace->faceEnabled()    },
+		{ m_rightFace->face() , m_rightFace->faceEnabled()  },
+		{ m_backFace->face()  , m_backFace->faceEnabled()   },
+		{ m_bottomFace->face(), m_bottomFace->faceEnabled() },
+		{ m_leftFace->face()  , m_leftFace->faceEnabled()   }
+	};
+
+	m_sources.clear();
+	m_loaderReady.clear();
+	m_fetched.clear();
+
+	for (auto it = urls.begin(); it != urls.end(); ++it)
+	{
+		if (enabled[it.key()])
+		{
+			m_sources[it.key()] = it.value();
+
+			// Loads are tracked per url, faces sharing a texture wait for the same download.
+			if (!m_loaderReady.contains(it.value()))
+			{
+				m_loaderReady[it.value()] = !RemoteFetcher::isRemote(it.value()) || ImageCache::instance()->contains(it.value());
+
+				if (!m_loaderReady[it.value()])
+				{
+					RemoteFetcher::instance()->fetch(it.value());
+				}
+			}
+		}
+	}
+
+	QTimer::singleShot(0, this, [this]() { checkLoaders(); });
+}
+
+void TemplateExporter::checkLoaders() {
+	// Both a cancel and a pending check can get here once preloading is over.
+	if (!m_busy || m_watcher->isRunning())
+	{
+		return;
+	}
+
+	if (!m_token.isCanceled())
+	{
+		long count = std::count_if(m_loaderReady.begin(), m_loaderReady.end(), [](bool ready){ return ready; });
+
+		setStatusMessage(tr("%1/%2 images loaded...").arg(count).arg(m_loaderReady.count()));
+		setProgress(m_preloadingStart + count * m_preloadingTotal / m_loaderReady.count());
+
+		if (count == m_loaderReady.count())
+		{
+			setProgress(m_preloadingStart + m_preloadingTotal);
+			startProcessing();
+		}
+	}
+	else
+	{
+		setStatusMessage(tr("Canceled while preloading images."));
+		setBusy(false);
+
+		emitAborted();
+	}
+}
+
+void TemplateExporter::remoteImageFetched(const QUrl& url, const QByteArray& data, const QString& error)
+{
+	if (!m_busy || m_watcher->isRunning() || !m_loaderReady.contains(url) || m_loaderReady[url])
+	{
+		return;
+	}
+
+	if (!error.isEmpty())
+	{
+		emitError(error);
+		setBusy(false);
+		return;
+	}
+
+	// Kept as downloaded, the worker decodes it.
+	m_fetched[url] = data;
+	m_loaderReady[url] = true;
+
+	checkLoaders();
+}
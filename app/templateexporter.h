@@ -29,12 +29,16 @@
 #include <QUrl>
 #include <QQmlEngine>
 #include <QFutureWatcher>
+#include <QTimer>
 
+#include "cancellationtoken.h"
+#include "exportjob.h"
 #include "templatedata.h"
 #include "templateface.h"
 #include "exportdata.h"
-
-class QQmlFile;
+#include "tileoptimizer.h"
+#include "exportwatcher.h"
+#include "tilelistmodel.h"
 
 class TemplateExporter : public QObject
 {
@@ -45,15 +49,22 @@ class TemplateExporter : public QObject
 	Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
 	Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorMessageChanged)
 	Q_PROPERTY(QString statusMessage READ statusMessage NOTIFY statusMessageChanged)
+	Q_PROPERTY(QString exportReport READ exportReport NOTIFY exportReportChanged)
+	Q_PROPERTY(bool optimizeOutput READ optimizeOutput WRITE setOptimizeOutput NOTIFY optimizeOutputChanged)
+	Q_PROPERTY(bool quantizeOutput READ quantizeOutput WRITE setQuantizeOutput NOTIFY quantizeOutputChanged)
+	Q_PROPERTY(bool watching READ watching WRITE setWatching NOTIFY watchingChanged)
+	Q_PROPERTY(bool exportVariants READ exportVariants WRITE setExportVariants NOTIFY exportVariantsChanged)
 	Q_PROPERTY(TemplateFace* frontFace READ frontFace CONSTANT)
 	Q_PROPERTY(TemplateFace* topFace READ topFace CONSTANT)
 	Q_PROPERTY(TemplateFace* rightFace READ rightFace CONSTANT)
 	Q_PROPERTY(TemplateFace* backFace READ backFace CONSTANT)
 	Q_PROPERTY(TemplateFace* bottomFace READ bottomFace CONSTANT)
 	Q_PROPERTY(TemplateFace* leftFace READ leftFace CONSTANT)
+	Q_PROPERTY(TileListModel* tiles READ tiles CONSTANT)
 
 public:
 	explicit TemplateExporter(QObject* parent = nullptr);
+	~TemplateExporter() override;
 
 	QUrl templateUrl() const;
 	void setTemplateUrl(const QUrl& templateUrl);
@@ -66,6 +77,19 @@ public:
 
 	QString errorMessage() const;
 	QString statusMessage() const;
+	QString exportReport() const;
+
+	bool optimizeOutput() const;
+	void setOptimizeOutput(bool optimizeOutput);
+
+	bool quantizeOutput() const;
+	void setQuantizeOutput(bool quantizeOutput);
+
+	bool watching() const;
+	void setWatching(bool watching);
+
+	bool exportVariants() const;
+	void setExportVariants(bool exportVariants);
 
 	TemplateFace* frontFace() const;
 	TemplateFace* topFace() const;
@@ -74,6 +98,8 @@ public:
 	TemplateFace* bottomFace() const;
 	TemplateFace* leftFace() const;
 
+	TileListModel* tiles() const;
+
 	TemplateData copyData() const;
 	ExportData exportData() const;
 
@@ -83,8 +109,13 @@ public:
 
 	Q_INVOKABLE QUrl alternativeResolve(const QString& path) const;
 	Q_INVOKABLE bool directoryExists(const QUrl& url) const;
+	Q_INVOKABLE bool saveJob(const QUrl& file);
+
+	// The editors as the last session left them, keyed by face and named after the FaceEditor properties.
+	Q_INVOKABLE QVariantMap session() const;
 
 	Q_INVOKABLE void exportToDirectory(const QUrl& directory);
+	Q_INVOKABLE void exportToDirectories(const QList<QUrl>& directories);
 	Q_INVOKABLE void cancel();
 
 signals:
@@ -95,49 +126,75 @@ signals:
 	void error(const QString& error);
 	void errorMessageChanged();
 	void statusMessageChanged();
+	void exportReportChanged();
+	void optimizeOutputChanged();
+	void quantizeOutputChanged();
+	void watchingChanged();
+	void exportVariantsChanged();
 	void aborted();
 	void finished();
 
 private slots:
 	void processFinished();
+	void saveSession();
 
 	void setProgress(qreal progress);
 	void setStatusMessage(const QString& message);
+	void setExportReport(const QString& report);
 
+	void emitError(const QString& message);
 	void emitAborted();
 
-	void templateImageFinished();
-
-	void frontImageFinished();
-	void topImageFinished();
-	void rightImageFinished();
-	void backImageFinished();
-	void bottomImageFinished();
-	void leftImageFinished();
+	void remoteImageFetched(const QUrl& url, const QByteArray& data, const QString& error);
+	void inputsChanged(const QStringList& keys);
 
 private:
-	QHash<QString, QImage> exportImages();
+	// The inputs of an export as the worker decoded and processed them, taken over by processFinished()
+	// as the state watch mode starts from once they are complete.
+	struct Prepared
+	{
+		ExportJob job;
+		QHash<QString, QUrl> sources;
+		ExportJob::Inputs inputs;
+
+		// Remote inputs as downloaded, decoded by the worker before anything else.
+		QHash<QUrl, QByteArray> fetched;
+
+		bool complete = false;
+	};
 
 	void setBusy(bool busy);
 
 	void setErrorMessage(const QString& message);
-	void emitError(const QString& message);
 
 	void checkLoaders();
 
 	void startProcessing();
+	bool startVariants();
 	void preloadImages();
-	void imageLoaded(const QString& owner, QQmlFile* file);
-	void processImage(TemplateFace* face, QImage& image) const;
+	void reexport(const QStringList& keys);
 
-	static void process(TemplateExporter* exporter, ExportData data, QHash<QString, QImage> images, QUrl destination);
+	static TileRenderer::Callbacks workerCallbacks(TemplateExporter* exporter, qreal start, qreal total, const CancellationToken& token);
+	static bool decodeFetched(TemplateExporter* exporter, const QHash<QUrl, QByteArray>& fetched, const CancellationToken& token);
+	static bool prepareImages(TemplateExporter* exporter, const QStringList& keys, Prepared& prepared, CancellationToken token);
+	static void process(TemplateExporter* exporter, const ExportJob& job, const ExportJob::Inputs& inputs,
+						const QStringList& directories, const QSet<FaceData::FaceIndex>& faces, const CancellationToken& token);
+	static void processVariants(TemplateExporter* exporter, const QVector<ExportJob>& jobs, const QStringList& names,
+								const QStringList& directories, const CancellationToken& token);
 
 private:
 	TemplateData m_data;
 
-	volatile bool m_canceled = false;
+	// Replaced by a fresh one for every export, the workers keep a copy of the one they started with.
+	CancellationToken m_token;
+
+	bool m_optimizeOutput = false;
+	bool m_quantizeOutput = false;
+	bool m_watching = false;
+	bool m_exportVariants = false;
 
 	bool m_busy = false;
+	bool m_failed = false; // the running export emitted an error
 	qreal m_progress = 0.0;
 
 	static constexpr qreal m_preloadingStart =  0.0;
@@ -149,10 +206,21 @@ private:
 	static constexpr qreal m_exportStart = m_imageProcessingStart + m_imageProcessingTotal;
 	static constexpr qreal m_exportTotal   = 80.0; // 20%-100% / 100%
 
-	QHash< QString, QSharedPointer<QQmlFile> > m_loaders;
-	QHash<QString, bool> m_loaderReady;
+	QHash<QString, QUrl> m_sources;
+	QHash<QUrl, bool> m_loaderReady;
+	QHash<QUrl, QByteArray> m_fetched;
 
 	QUrl m_exportUrl;
+	QStringList m_exportDirectories;
+
+	// What the last export used, kept warm so watch mode only redoes what changed.
+	ExportJob m_lastJob;
+	QHash<QString, QUrl> m_lastSources;
+	ExportJob::Inputs m_lastInputs;
+	QStringList m_pendingChanges;
+	QSharedPointer<Prepared> m_prepared;
+
+	ExportWatcher* m_inputWatcher;
 
 	QFutureWatcher<void>* m_watcher;
 
@@ -163,8 +231,15 @@ private:
 	TemplateFace* m_bottomFace;
 	TemplateFace* m_leftFace;
 
+	TileListModel* m_tiles;
+
+	// Restarted by every change, the session is written once the edits settle.
+	QTimer* m_sessionTimer;
+	static constexpr int m_sessionDelay = 500; // milliseconds
+
 	QString m_errorMessage;
 	QString m_statusMessage;
+	QString m_exportReport;
 };
 
 #endif // TEMPLATEEXPORTER_H
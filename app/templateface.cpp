@@ -24,11 +24,20 @@
 
 #include "templateface.h"
 
-TemplateFace::TemplateFace(const QString& face, FaceData::FaceIndex index, const QString& text, QObject* parent) : QObject(parent)
+#include <QTimer>
+
+TemplateFace::TemplateFace(const QString& face, FaceData::FaceIndex index, const QString& text, QObject* parent) :
+	QObject(parent),
+	m_flushTimer(new QTimer(this))
 {
 	m_data.face() = face;
 	m_data.index() = index;
 	m_data.text() = text;
+
+	m_flushTimer->setSingleShot(true);
+	m_flushTimer->setInterval(m_frameInterval);
+
+	connect(m_flushTimer, &QTimer::timeout, this, &TemplateFace::flush);
 }
 
 QString TemplateFace::face() const
@@ -54,7 +63,7 @@ void TemplateFace::setFaceEnabled(bool faceEnabled)
 	if (m_data.enabled() != faceEnabled)
 	{
 		m_data.enabled() = faceEnabled;
-		emit faceEnabledChanged();
+		notify(FACE_ENABLED);
 	}
 }
 
@@ -68,7 +77,7 @@ void TemplateFace::setFaceRect(const QRect& faceRect)
 	if (m_data.faceRect() != faceRect)
 	{
 		m_data.faceRect() = faceRect;
-		emit faceRectChanged();
+		notify(FACE_RECT);
 	}
 }
 
@@ -82,7 +91,7 @@ void TemplateFace::setHorizontalCount(int horizontalCount)
 	if (m_data.horizontalCount() != horizontalCount)
 	{
 		m_data.horizontalCount() = horizontalCount;
-		emit horizontalCountChanged();
+		notify(HORIZONTAL_COUNT);
 	}
 }
 
@@ -96,7 +105,7 @@ void TemplateFace::setVerticalCount(int verticalCount)
 	if (m_data.verticalCount() != verticalCount)
 	{
 		m_data.verticalCount() = verticalCount;
-		emit verticalCountChanged();
+		notify(VERTICAL_COUNT);
 	}
 }
 
@@ -110,7 +119,7 @@ void TemplateFace::setFaceImageUrl(const QUrl& faceImageUrl)
 	if (m_data.faceImageUrl() != faceImageUrl)
 	{
 		m_data.faceImageUrl() = faceImageUrl;
-		emit faceImageUrlChanged();
+		notify(FACE_IMAGE_URL);
 	}
 }
 
@@ -124,7 +133,7 @@ void TemplateFace::setResizeSource(bool resizeSource)
 	if (m_data.resizeSource() != resizeSource)
 	{
 		m_data.resizeSource() = resizeSource;
-		emit resizeSourceChanged();
+		notify(RESIZE_SOURCE);
 	}
 }
 
@@ -138,7 +147,7 @@ void TemplateFace::setPreserveAspectRatio(bool preserveAspectRatio)
 	if (m_data.preserveAspectRatio() != preserveAspectRatio)
 	{
 		m_data.preserveAspectRatio() = preserveAspectRatio;
-		emit preserveAspectRatioChanged();
+		notify(PRESERVE_ASPECT_RATIO);
 	}
 }
 
@@ -152,7 +161,7 @@ void TemplateFace::setAspectRatioAction(AspectRatioAction aspectRatioAction)
 	if (m_data.aspectRatioAction() != aspectRatioAction)
 	{
 		m_data.aspectRatioAction() = aspectRatioAction;
-		emit aspectRatioActionChanged();
+		notify(ASPECT_RATIO_ACTION);
 	}
 }
 
@@ -166,7 +175,7 @@ void TemplateFace::setFitRect(const QRect& fitRect)
 	if (m_data.fitRect() != fitRect)
 	{
 		m_data.fitRect() = fitRect;
-		emit fitRectChanged();
+		notify(FIT_RECT);
 	}
 }
 
@@ -180,7 +189,7 @@ void TemplateFace::setCropRect(const QRect& cropRect)
 	if (m_data.cropRect() != cropRect)
 	{
 		m_data.cropRect() = cropRect;
-		emit cropRectChanged();
+		notify(CROP_RECT);
 	}
 }
 
@@ -188,3 +197,81 @@ FaceData TemplateFace::copyData() const
 {
 	return m_data;
 }
+
+void TemplateFace::beginUpdate()
+{
+	++m_updateDepth;
+}
+
+void TemplateFace::endUpdate()
+{
+	if (m_updateDepth == 0 || --m_updateDepth > 0)
+	{
+		return;
+	}
+
+	Fields batched = m_batched;
+	m_batched = Fields();
+
+	for (int bit = FACE_ENABLED; bit <= CROP_RECT; bit <<= 1)
+	{
+		if (batched.testFlag(Field(bit)))
+		{
+			emitNotify(Field(bit));
+		}
+	}
+
+	if (m_pending != Fields() && !m_flushTimer->isActive())
+	{
+		m_flushTimer->start();
+	}
+}
+
+void TemplateFace::notify(Field field)
+{
+	m_pending |= field;
+
+	if (m_updateDepth > 0)
+	{
+		m_batched |= field;
+		return;
+	}
+
+	emitNotify(field);
+
+	if (!m_flushTimer->isActive())
+	{
+		m_flushTimer->start();
+	}
+}
+
+void TemplateFace::emitNotify(Field field)
+{
+	switch (field)
+	{
+		case FACE_ENABLED: emit faceEnabledChanged(); break;
+		case FACE_RECT: emit faceRectChanged(); break;
+		case HORIZONTAL_COUNT: emit horizontalCountChanged(); break;
+		case VERTICAL_COUNT: emit verticalCountChanged(); break;
+		case FACE_IMAGE_URL: emit faceImageUrlChanged(); break;
+		case RESIZE_SOURCE: emit resizeSourceChanged(); break;
+		case PRESERVE_ASPECT_RATIO: emit preserveAspectRatioChanged(); break;
+		case ASPECT_RATIO_ACTION: emit aspectRatioActionChanged(); break;
+		case FIT_RECT: emit fitRectChanged(); break;
+		case CROP_RECT: emit cropRectChanged(); break;
+	}
+}
+
+void TemplateFace::flush()
+{
+	// Still inside an update, endUpdate() restarts the timer.
+	if (m_updateDepth > 0)
+	{
+		return;
+	}
+
+	Fields fields = m_pending;
+	m_pending = Fields();
+
+	emit changed(fields);
+}
@@ -32,6 +32,11 @@
 
 #include "facedata.h"
 
+class QTimer;
+
+// Setters notify their property right away, outside of an update. Every change is also collected into a mask and
+// reported once per frame through changed(), for consumers that only need to recompute once. Between beginUpdate()
+// and endUpdate() even the property signals wait, and each one fires once at the end.
 class TemplateFace : public QObject
 {
 	Q_OBJECT
@@ -56,6 +61,21 @@ public:
 	};
 	Q_ENUM(AspectRatioAction)
 
+	enum Field {
+		FACE_ENABLED = 0x001,
+		FACE_RECT = 0x002,
+		HORIZONTAL_COUNT = 0x004,
+		VERTICAL_COUNT = 0x008,
+		FACE_IMAGE_URL = 0x010,
+		RESIZE_SOURCE = 0x020,
+		PRESERVE_ASPECT_RATIO = 0x040,
+		ASPECT_RATIO_ACTION = 0x080,
+		FIT_RECT = 0x100,
+		CROP_RECT = 0x200
+	};
+	Q_DECLARE_FLAGS(Fields, Field)
+	Q_FLAG(Fields)
+
 	explicit TemplateFace(QObject* parent = nullptr) = delete;
 	explicit TemplateFace(const QString& face, FaceData::FaceIndex index, const QString& text, QObject* parent = nullptr);
 
@@ -95,9 +115,14 @@ public:
 
 	FaceData copyData() const;
 
+	Q_INVOKABLE void beginUpdate();
+	Q_INVOKABLE void endUpdate();
+
 signals:
 	void faceChanged();
 
+	void changed(TemplateFace::Fields fields);
+
 	void faceEnabledChanged();
 
 	void faceRectChanged();
@@ -115,8 +140,23 @@ signals:
 	void fitRectChanged();
 	void cropRectChanged();
 
+private:
+	void notify(Field field);
+	void emitNotify(Field field);
+	void flush();
+
 private:
 	FaceData m_data;
+
+	int m_updateDepth = 0;
+	Fields m_batched;
+	Fields m_pending;
+
+	QTimer* m_flushTimer;
+
+	static constexpr int m_frameInterval = 16; // milliseconds
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(TemplateFace::Fields)
+
 #endif // TEMPLATEFACE_H
@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TEMPLATELAYOUT_H
+#define TEMPLATELAYOUT_H
+
+#include "facedata.h"
+
+#include <QString>
+#include <QRect>
+#include <QUrl>
+#include <QMap>
+#include <QPolygonF>
+
+class TemplateLayout
+{
+public:
+	QString& text()									{ return m_text; }
+	const QString& text() const						{ return m_text; }
+
+	QString& family()								{ return m_family; }
+	const QString& family() const					{ return m_family; }
+
+	QUrl& imageUrl()								{ return m_imageUrl; }
+	const QUrl& imageUrl() const					{ return m_imageUrl; }
+
+	bool& custom()									{ return m_custom; }
+	bool custom() const								{ return m_custom; }
+
+	QMap<FaceData::FaceIndex, QRect>& faceRects()				{ return m_faceRects; }
+	const QMap<FaceData::FaceIndex, QRect>& faceRects() const	{ return m_faceRects; }
+
+	QMap<FaceData::FaceIndex, QPolygonF>& faceMasks()				{ return m_faceMasks; }
+	const QMap<FaceData::FaceIndex, QPolygonF>& faceMasks() const	{ return m_faceMasks; }
+
+	QRect& bounds()									{ return m_bounds; }
+	const QRect& bounds() const						{ return m_bounds; }
+
+	bool hasFace(FaceData::FaceIndex index) const	{ return m_faceRects.contains(index); }
+	QRect faceRect(FaceData::FaceIndex index) const	{ return m_faceRects.value(index); }
+	QPolygonF faceMask(FaceData::FaceIndex index) const	{ return m_faceMasks.value(index); }
+
+private:
+	QString m_text;
+	QString m_family;
+
+	QUrl m_imageUrl;
+
+	bool m_custom = false;
+
+	QMap<FaceData::FaceIndex, QRect> m_faceRects;
+	QMap<FaceData::FaceIndex, QPolygonF> m_faceMasks;
+	QRect m_bounds;
+};
+
+#endif // TEMPLATELAYOUT_H
@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "tilelistmodel.h"
+#include "tilethumbnailprovider.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+TileListModel::TileListModel(QObject* parent) : QAbstractListModel(parent)
+{
+}
+
+void TileListModel::load(const QString& directory, const ExportPlan& plan)
+{
+	beginResetModel();
+
+	QDir path(directory);
+
+	m_directory = directory;
+	m_entries.clear();
+	m_entries.reserve(plan.tiles().count());
+
+	// Bumped on every export so the views ask for new thumbnails of rewritten files.
+	++m_revision;
+
+	for (const auto& tile : plan.tiles())
+	{
+		QFileInfo info(path.filePath(tile.fileName));
+
+		Entry entry;
+		entry.name = tile.fileName;
+		entry.face = plan.data().faces()[tile.mainIndex].text();
+		entry.position = tile.mainPoint + QPoint(1, 1);
+		entry.written = info.exists();
+		entry.size = entry.written ? info.size() : 0;
+
+		m_entries.append(entry);
+	}
+
+	endResetModel();
+
+	emit countChanged();
+}
+
+void TileListModel::clear()
+{
+	beginResetModel();
+
+	m_directory.clear();
+	m_entries.clear();
+
+	endResetModel();
+
+	emit countChanged();
+}
+
+int TileListModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_entries.count();
+}
+
+QVariant TileListModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_entries.count())
+	{
+		return QVariant();
+	}
+
+	const Entry& entry = m_entries[index.row()];
+
+	switch (role)
+	{
+		case Qt::DisplayRole:
+		case NameRole:		return entry.name;
+		case FaceRole:		return entry.face;
+		case PositionRole:	return QString("%1,%2").arg(entry.position.x()).arg(entry.position.y());
+		case StatusRole:	return entry.written ? "written" : "missing";
+		case SizeRole:		return entry.size;
+		case ThumbnailRole:	return entry.written ? TileThumbnailProvider::url(QDir(m_directory).filePath(entry.name), m_revision) : QUrl();
+		default:			return QVariant();
+	}
+}
+
+QHash<int, QByteArray> TileListModel::roleNames() const
+{
+	return {
+		{ NameRole, "name" },
+		{ FaceRole, "face" },
+		{ PositionRole, "position" },
+		{ StatusRole, "status" },
+		{ SizeRole, "size" },
+		{ ThumbnailRole, "thumbnail" }
+	};
+}
+
+int TileListModel::count() const
+{
+	return m_entries.count();
+}
+
+QUrl TileListModel::directory() const
+{
+	return QUrl::fromLocalFile(m_directory);
+}
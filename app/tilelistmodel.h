@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TILELISTMODEL_H
+#define TILELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QUrl>
+#include <QVector>
+
+#include "exportplan.h"
+
+// The tiles of the last export and what ended up on disk, for browsing them without a file manager.
+class TileListModel : public QAbstractListModel
+{
+	Q_OBJECT
+	Q_PROPERTY(int count READ count NOTIFY countChanged)
+	Q_PROPERTY(QUrl directory READ directory NOTIFY countChanged)
+
+public:
+	enum Roles {
+		NameRole = Qt::UserRole + 1,
+		FaceRole,
+		PositionRole,
+		StatusRole,
+		SizeRole,
+		ThumbnailRole
+	};
+
+	explicit TileListModel(QObject* parent = nullptr);
+
+	void load(const QString& directory, const ExportPlan& plan);
+	void clear();
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QHash<int, QByteArray> roleNames() const override;
+
+	int count() const;
+	QUrl directory() const;
+
+signals:
+	void countChanged();
+
+private:
+	struct Entry
+	{
+		QString name;
+		QString face;
+		QPoint position;
+		bool written = false;
+		qint64 size = 0;
+	};
+
+	QString m_directory;
+	QVector<Entry> m_entries;
+
+	int m_revision = 0;
+};
+
+#endif // TILELISTMODEL_H
@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "tilethumbnailprovider.h"
+
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QUrl>
+
+TileThumbnailProvider::TileThumbnailProvider() :
+	QQuickImageProvider(QQuickImageProvider::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading),
+	m_thumbnails(m_budget)
+{
+}
+
+QString TileThumbnailProvider::providerName()
+{
+	return "waifu2ugc-tiles";
+}
+
+QUrl TileThumbnailProvider::url(const QString& path, int revision)
+{
+	auto id = path.toUtf8().toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+
+	return QUrl(QString("image://%1/%2/%3").arg(providerName()).arg(revision).arg(QString::fromLatin1(id)));
+}
+
+QImage TileThumbnailProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
+{
+	QString key = QString("%1@%2x%3").arg(id).arg(requestedSize.width()).arg(requestedSize.height());
+
+	{
+		QMutexLocker lock(&m_mutex);
+
+		if (QImage* cached = m_thumbnails.object(key))
+		{
+			if (size != nullptr) *size = cached->size();
+			return *cached;
+		}
+	}
+
+	QString path = QString::fromUtf8(QByteArray::fromBase64(id.section('/', 1).toLatin1(), QByteArray::Base64UrlEncoding));
+	QImageReader reader(path);
+
+	if (requestedSize.width() > 0 && requestedSize.height() > 0 && reader.size().isValid())
+	{
+		reader.setScaledSize(reader.size().scaled(requestedSize, Qt::KeepAspectRatio));
+	}
+
+	QImage image = reader.read();
+
+	if (size != nullptr)
+	{
+		*size = image.size();
+	}
+
+	if (!image.isNull())
+	{
+		QMutexLocker lock(&m_mutex);
+		m_thumbnails.insert(key, new QImage(image), std::max(1, int(image.sizeInBytes() / 1024)));
+	}
+
+	return image;
+}
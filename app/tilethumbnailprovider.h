@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TILETHUMBNAILPROVIDER_H
+#define TILETHUMBNAILPROVIDER_H
+
+#include <QCache>
+#include <QMutex>
+#include <QQuickImageProvider>
+
+// Decodes exported tiles at thumbnail size on the QML loader threads. Thumbnails are kept in a
+// small cache of their own, so browsing thousands of tiles does not evict the face images.
+class TileThumbnailProvider : public QQuickImageProvider
+{
+public:
+	TileThumbnailProvider();
+
+	static QString providerName();
+	static QUrl url(const QString& path, int revision);
+
+	QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
+
+private:
+	QMutex m_mutex;
+	QCache<QString, QImage> m_thumbnails;
+
+	static constexpr int m_budget = 64 * 1024; // KiB
+};
+
+#endif // TILETHUMBNAILPROVIDER_H
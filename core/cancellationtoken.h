@@ -0,0 +1,69 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <QSharedPointer>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+// Shared between whoever cancels an export and every stage working on it. Stages poll isCanceled() between
+// bounded units of work (a band of rows, a blit, a deflate band), so a cancel is observed within milliseconds.
+// Copies share the same state; a fresh token is made for every export.
+class CancellationToken
+{
+public:
+	CancellationToken() : m_canceledAt(new std::atomic<qint64>(0))
+	{
+	}
+
+	void cancel() const
+	{
+		qint64 expected = 0;
+		m_canceledAt->compare_exchange_strong(expected, now());
+	}
+
+	bool isCanceled() const		{ return m_canceledAt->load(std::memory_order_relaxed) != 0; }
+
+	// Nanoseconds since the first cancel(), 0 while the token is still live.
+	qint64 sinceCancel() const
+	{
+		qint64 canceledAt = m_canceledAt->load();
+		return canceledAt != 0 ? now() - canceledAt : 0;
+	}
+
+private:
+	static qint64 now()
+	{
+		return std::max<qint64>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+private:
+	QSharedPointer< std::atomic<qint64> > m_canceledAt;
+};
+
+#endif // CANCELLATIONTOKEN_H
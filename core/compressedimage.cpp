@@ -0,0 +1,235 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "compressedimage.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPair>
+
+#include <algorithm>
+#include <cstring>
+
+CompressedImage::BlockCache::BlockCache(int kilobytes) :
+	m_blocks(kilobytes)
+{
+}
+
+int CompressedImage::BlockCache::inflates() const
+{
+	return m_inflates;
+}
+
+CompressedImage CompressedImage::compress(const QImage& image, const QSize& blockSize)
+{
+	CompressedImage compressed;
+
+	if (image.isNull())
+	{
+		return compressed;
+	}
+
+	QSharedPointer<Data> data(new Data);
+	data->size = image.size();
+	data->format = image.format();
+	data->bytesPerLine = image.bytesPerLine();
+	data->depth = image.depth();
+	data->blockSize = QSize(image.depth() < 8 ? image.width() : std::max(1, std::min(blockSize.width(), image.width())),
+							std::max(1, std::min(blockSize.height(), image.height())));
+	data->columns = (image.width() + data->blockSize.width() - 1) / data->blockSize.width();
+	data->colorTable = image.colorTable();
+
+	int rows = (image.height() + data->blockSize.height() - 1) / data->blockSize.height();
+	data->blocks.resize(data->columns * rows);
+
+	QVector<int> indices;
+
+	for (int i = 0; i < data->blocks.count(); ++i)
+	{
+		indices.append(i);
+	}
+
+	compressed.m_data = data;
+
+	// Blocks are independent, so they are compressed on every core.
+	Data* target = data.data();
+
+	QtConcurrent::blockingMap(indices, [target, &compressed, &image](int index) {
+		QRect rect = compressed.blockRect(index);
+		int rowBytes = compressed.rowBytes(rect);
+
+		QByteArray rows(rowBytes * rect.height(), Qt::Uninitialized);
+
+		for (int y = 0; y < rect.height(); ++y)
+		{
+			std::memcpy(rows.data() + y * rowBytes, image.constScanLine(rect.top() + y) + rect.left() * (target->depth / 8), size_t(rowBytes));
+		}
+
+		target->blocks[index] = qCompress(rows, m_compressionLevel);
+	});
+
+	return compressed;
+}
+
+bool CompressedImage::worthCompressing(const QImage& image)
+{
+	return image.sizeInBytes() >= m_threshold;
+}
+
+bool CompressedImage::isNull() const
+{
+	return m_data.isNull();
+}
+
+QSize CompressedImage::size() const
+{
+	return m_data.isNull() ? QSize() : m_data->size;
+}
+
+QSize CompressedImage::blockSize() const
+{
+	return m_data.isNull() ? QSize() : m_data->blockSize;
+}
+
+qint64 CompressedImage::compressedBytes() const
+{
+	qint64 bytes = 0;
+
+	if (!m_data.isNull())
+	{
+		for (const QByteArray& block : m_data->blocks)
+		{
+			bytes += block.size();
+		}
+	}
+
+	return bytes;
+}
+
+QImage CompressedImage::copy(const QRect& rect, BlockCache& cache) const
+{
+	if (m_data.isNull())
+	{
+		return QImage();
+	}
+
+	QRect area = rect.intersected(QRect(QPoint(0, 0), m_data->size));
+
+	if (area.isEmpty())
+	{
+		return QImage();
+	}
+
+	int firstColumn = area.left() / m_data->blockSize.width();
+	int lastColumn = area.right() / m_data->blockSize.width();
+	int firstRow = area.top() / m_data->blockSize.height();
+	int lastRow = area.bottom() / m_data->blockSize.height();
+
+	// The common case, a face cell matching one block, is a plain copy out of that block.
+	if (firstColumn == lastColumn && firstRow == lastRow)
+	{
+		int index = firstRow * m_data->columns + firstColumn;
+
+		return block(index, cache).copy(area.translated(-blockRect(index).topLeft()));
+	}
+
+	QImage result(area.size(), m_data->format);
+	result.setColorTable(m_data->colorTable);
+
+	for (int row = firstRow; row <= lastRow; ++row)
+	{
+		for (int column = firstColumn; column <= lastColumn; ++column)
+		{
+			int index = row * m_data->columns + column;
+			QImage pixels = block(index, cache);
+
+			if (pixels.isNull())
+			{
+				return QImage();
+			}
+
+			QRect part = area.intersected(blockRect(index));
+			QRect source = part.translated(-blockRect(index).topLeft());
+
+			// Below 8 bits per pixel the blocks are whole rows, a copy of each lines up with the result.
+			QImage piece = m_data->depth < 8 ? pixels.copy(source) : pixels;
+			QPoint origin = m_data->depth < 8 ? QPoint(0, 0) : source.topLeft();
+			int bytesPerPixel = m_data->depth / 8;
+			int bytes = m_data->depth < 8 ? piece.bytesPerLine() : part.width() * bytesPerPixel;
+
+			for (int y = 0; y < part.height(); ++y)
+			{
+				std::memcpy(result.scanLine(part.top() - area.top() + y) + (part.left() - area.left()) * bytesPerPixel,
+							piece.constScanLine(origin.y() + y) + origin.x() * bytesPerPixel, size_t(bytes));
+			}
+		}
+	}
+
+	return result;
+}
+
+QRect CompressedImage::blockRect(int index) const
+{
+	QPoint topLeft((index % m_data->columns) * m_data->blockSize.width(), (index / m_data->columns) * m_data->blockSize.height());
+
+	return QRect(topLeft, m_data->blockSize).intersected(QRect(QPoint(0, 0), m_data->size));
+}
+
+int CompressedImage::rowBytes(const QRect& blockRect) const
+{
+	return m_data->depth < 8 ? m_data->bytesPerLine : blockRect.width() * (m_data->depth / 8);
+}
+
+// Keyed by the shared data, which the images using the cache keep alive as long as it.
+QImage CompressedImage::block(int index, BlockCache& cache) const
+{
+	QPair<quintptr, int> key(quintptr(m_data.data()), index);
+
+	if (const QImage* cached = cache.m_blocks.object(key))
+	{
+		return *cached;
+	}
+
+	QByteArray bytes = qUncompress(m_data->blocks[index]);
+	++cache.m_inflates;
+
+	QRect rect = blockRect(index);
+	int bytesPerRow = rowBytes(rect);
+
+	if (bytes.size() != bytesPerRow * rect.height())
+	{
+		return QImage();
+	}
+
+	QImage image(rect.size(), m_data->format);
+	image.setColorTable(m_data->colorTable);
+
+	for (int y = 0; y < rect.height(); ++y)
+	{
+		std::memcpy(image.scanLine(y), bytes.constData() + y * bytesPerRow, size_t(std::min(bytesPerRow, image.bytesPerLine())));
+	}
+
+	cache.m_blocks.insert(key, new QImage(image), std::max(1, int(image.sizeInBytes() / 1024)));
+
+	return image;
+}
@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef COMPRESSEDIMAGE_H
+#define COMPRESSEDIMAGE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "waifu2ugccore.h"
+
+// A large processed face kept as zlib compressed blocks, for exports whose faces would not fit in memory decoded.
+// Blocks are one face cell each, so a tile unpacks exactly the cells it draws whatever order the tiles come in.
+// Readers unpack only the blocks covering the rect they copy; recently unpacked blocks are kept in the reader's
+// BlockCache.
+class WAIFU2UGC_CORE_EXPORT CompressedImage
+{
+public:
+	// Owned by one compositing thread for one export, the images it holds blocks of must outlive it.
+	class BlockCache
+	{
+	public:
+		explicit BlockCache(int kilobytes = 64 * 1024);
+
+		// Blocks unpacked through this cache so far.
+		int inflates() const;
+
+	private:
+		friend class CompressedImage;
+
+		QCache<QPair<quintptr, int>, QImage> m_blocks;
+		int m_inflates = 0;
+	};
+
+	CompressedImage() = default;
+
+	// Images below 8 bits per pixel are split into rows of blocks only.
+	static CompressedImage compress(const QImage& image, const QSize& blockSize);
+	static bool worthCompressing(const QImage& image);
+
+	bool isNull() const;
+	QSize size() const;
+	QSize blockSize() const;
+	qint64 compressedBytes() const;
+
+	QImage copy(const QRect& rect, BlockCache& cache) const;
+
+private:
+	struct Data
+	{
+		QSize size;
+		QImage::Format format = QImage::Format_Invalid;
+		int bytesPerLine = 0;
+		int depth = 0;
+		QSize blockSize;
+		int columns = 1;
+		QVector<QRgb> colorTable;
+		QVector<QByteArray> blocks;
+	};
+
+	QRect blockRect(int index) const;
+	int rowBytes(const QRect& blockRect) const;
+	QImage block(int index, BlockCache& cache) const;
+
+private:
+	QSharedPointer<const Data> m_data;
+
+	static constexpr qint64 m_threshold = 64 * 1024 * 1024;
+	static constexpr int m_compressionLevel = 1;
+};
+
+#endif // COMPRESSEDIMAGE_H
@@ -0,0 +1,62 @@
+QT += gui network concurrent
+
+TEMPLATE = lib
+TARGET = waifu2ugc-core
+
+CONFIG += c++11
+
+# Shared by default, `qmake CONFIG+=waifu2ugc_static` builds a static archive instead.
+waifu2ugc_static {
+    CONFIG += staticlib
+    DEFINES += WAIFU2UGC_CORE_STATIC
+} else {
+    DEFINES += WAIFU2UGC_CORE_LIBRARY
+}
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        compressedimage.cpp \
+        exportdata.cpp \
+        exportjob.cpp \
+        exportplan.cpp \
+        facemask.cpp \
+        faceprocessor.cpp \
+        imagecache.cpp \
+        pngbandencoder.cpp \
+        processedstore.cpp \
+        remotefetcher.cpp \
+        stagetuner.cpp \
+        thumbnailstore.cpp \
+        tileoptimizer.cpp \
+        tilerenderer.cpp \
+        tilewriter.cpp
+
+HEADERS += \
+    cancellationtoken.h \
+    compressedimage.h \
+    exportdata.h \
+    exportjob.h \
+    exportplan.h \
+    facedata.h \
+    facemask.h \
+    faceprocessor.h \
+    imagecache.h \
+    pngbandencoder.h \
+    processedstore.h \
+    remotefetcher.h \
+    shardspec.h \
+    stagetuner.h \
+    templatedata.h \
+    thumbnailstore.h \
+    tileoptimizer.h \
+    tilerenderer.h \
+    tilewriter.h \
+    waifu2ugccore.h
+
+# Tiles are deflated directly, see PngBandEncoder. Windows builds use the zlib bundled with Qt.
+unix: LIBS += -lz
+win32: INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+
+unix:!android: target.path = /opt/waifu2ugc/lib
+!isEmpty(target.path): INSTALLS += target
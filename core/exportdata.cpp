@@ -0,0 +1,197 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "exportdata.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+
+static QJsonArray rectToJson(const QRect& rect)
+{
+	return QJsonArray { rect.x(), rect.y(), rect.width(), rect.height() };
+}
+
+static QRect rectFromJson(const QJsonValue& value)
+{
+	QJsonArray numbers = value.toArray();
+
+	return numbers.count() == 4 ? QRect(numbers[0].toInt(), numbers[1].toInt(), numbers[2].toInt(), numbers[3].toInt()) : QRect();
+}
+
+static QJsonArray polygonToJson(const QPolygonF& polygon)
+{
+	QJsonArray points;
+
+	for (const QPointF& point : polygon)
+	{
+		points.append(QJsonArray { point.x(), point.y() });
+	}
+
+	return points;
+}
+
+static QPolygonF polygonFromJson(const QJsonValue& value)
+{
+	QPolygonF polygon;
+
+	for (const auto& point : value.toArray())
+	{
+		QJsonArray numbers = point.toArray();
+
+		if (numbers.count() == 2)
+		{
+			polygon.append(QPointF(numbers[0].toDouble(), numbers[1].toDouble()));
+		}
+	}
+
+	return polygon.count() >= 3 ? polygon : QPolygonF();
+}
+
+int ExportData::getXAxisSize() const {
+	int count = 0;
+
+	for (auto& face : m_faces)
+	{
+		if (face.enabled() && face.affectsXHorizontally())
+		{
+			count = std::max(count, face.horizontalCount());
+		}
+	}
+
+	return count;
+}
+
+int ExportData::getYAxisSize() const {
+	int count = 0;
+
+	for (auto& face : m_faces)
+	{
+		if (face.enabled() && face.affectsYVertically())
+		{
+			count = std::max(count, face.verticalCount());
+		}
+	}
+
+	return count;
+}
+
+int ExportData::getZAxisSize() const {
+	int count = 0;
+
+	for (auto& face : m_faces)
+	{
+		if (face.enabled())
+		{
+			if (face.affectsZHorizontally())
+			{
+				count = std::max(count, face.horizontalCount());
+			}
+			else if (face.affectsZVertically())
+			{
+				count = std::max(count, face.verticalCount());
+			}
+		}
+	}
+
+	return count;
+}
+
+QJsonObject ExportData::toJson() const
+{
+	QJsonObject faces;
+
+	for (const auto& face : m_faces)
+	{
+		faces[face.face()] = QJsonObject {
+			{ "text", face.text() },
+			{ "enabled", face.enabled() },
+			{ "faceRect", rectToJson(face.faceRect()) },
+			{ "horizontalCount", face.horizontalCount() },
+			{ "verticalCount", face.verticalCount() },
+			{ "image", face.faceImageUrl().toString() },
+			{ "resizeSource", face.resizeSource() },
+			{ "preserveAspectRatio", face.preserveAspectRatio() },
+			{ "aspectRatioAction", face.aspectRatioAction() },
+			{ "fitRect", rectToJson(face.fitRect()) },
+			{ "cropRect", rectToJson(face.cropRect()) },
+			{ "mask", polygonToJson(face.mask()) }
+		};
+	}
+
+	return QJsonObject {
+		{ "template", m_template.templateUrl().toString() },
+		{ "faces", faces }
+	};
+}
+
+bool ExportData::fromJson(const QJsonObject& json, ExportData& data, QString* error)
+{
+	data = ExportData();
+	data.source().templateUrl() = QUrl(json["template"].toString());
+
+	if (data.source().templateUrl().isEmpty())
+	{
+		if (error != nullptr) *error = QCoreApplication::translate("ExportData", "The job has no template.");
+		return false;
+	}
+
+	QJsonObject faces = json["faces"].toObject();
+
+	for (auto it = faces.begin(); it != faces.end(); ++it)
+	{
+		FaceData::FaceIndex index = FaceData::indexFromName(it.key());
+
+		if (index == FaceData::INVALID)
+		{
+			if (error != nullptr) *error = QCoreApplication::translate("ExportData", "Unknown face '%1' in job.").arg(it.key());
+			return false;
+		}
+
+		const QJsonObject object = it.value().toObject();
+		FaceData& face = data.face(index);
+
+		face.face() = it.key();
+		face.index() = index;
+		face.text() = object["text"].toString();
+		face.enabled() = object["enabled"].toBool();
+		face.faceRect() = rectFromJson(object["faceRect"]);
+		face.horizontalCount() = object["horizontalCount"].toInt(1);
+		face.verticalCount() = object["verticalCount"].toInt(1);
+		face.faceImageUrl() = QUrl(object["image"].toString());
+		face.resizeSource() = object["resizeSource"].toBool();
+		face.preserveAspectRatio() = object["preserveAspectRatio"].toBool();
+		face.aspectRatioAction() = object["aspectRatioAction"].toInt();
+		face.fitRect() = rectFromJson(object["fitRect"]);
+		face.cropRect() = rectFromJson(object["cropRect"]);
+		face.mask() = polygonFromJson(object["mask"]);
+
+		if (face.enabled() && (face.faceImageUrl().isEmpty() || face.faceRect().isEmpty()))
+		{
+			if (error != nullptr) *error = QCoreApplication::translate("ExportData", "Face '%1' is enabled but has no image or rect.").arg(it.key());
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -25,12 +25,14 @@
 #ifndef EXPORTDATA_H
 #define EXPORTDATA_H
 
+#include "waifu2ugccore.h"
 #include "templatedata.h"
 #include "facedata.h"
 
 #include <QMap>
+#include <QJsonObject>
 
-class ExportData
+class WAIFU2UGC_CORE_EXPORT ExportData
 {
 public:
 	TemplateData& source()				{ return m_template; }
@@ -63,6 +65,9 @@ public:
 	int getYAxisSize() const;
 	int getZAxisSize() const;
 
+	QJsonObject toJson() const;
+	static bool fromJson(const QJsonObject& json, ExportData& data, QString* error = nullptr);
+
 private:
 	TemplateData m_template;
 
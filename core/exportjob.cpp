@@ -0,0 +1,570 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "exportjob.h"
+#include "faceprocessor.h"
+#include "processedstore.h"
+#include "imagecache.h"
+#include "remotefetcher.h"
+
+#include <QCache>
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QLocale>
+#include <QStorageInfo>
+
+// Faces processed for recent jobs, so a stream of jobs sharing inputs skips the resampling too.
+// Costs are in KiB, keyed like the ProcessedStore so a changed texture, local or remote, gets a new key.
+namespace
+{
+	struct Processed
+	{
+		QImage image;
+		bool mapped; // from the ProcessedStore, costs no memory
+	};
+}
+
+static QMutex processedMutex;
+static QCache<QString, Processed> processedFaces(256 * 1024);
+
+QJsonObject ExportJob::toJson() const
+{
+	QJsonObject job = m_data.toJson();
+
+	job["options"] = QJsonObject {
+		{ "optimize", m_options.optimize },
+		{ "quantize", m_options.quantize }
+	};
+
+	return job;
+}
+
+bool ExportJob::fromJson(const QJsonObject& json, ExportJob& job, QString* error)
+{
+	const QJsonObject options = json.value("options").toObject();
+
+	job.m_options.optimize = options.value("optimize").toBool();
+	job.m_options.quantize = options.value("quantize").toBool();
+
+	return ExportData::fromJson(json, job.m_data, error);
+}
+
+bool ExportJob::load(const QString& path, ExportJob& job, QString* error)
+{
+	QFile file(path);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		if (error != nullptr) *error = tr("Failed to open job:\r\n%1\r\n%2").arg(path, file.errorString());
+		return false;
+	}
+
+	QJsonParseError parseError;
+	QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+	if (!document.isObject())
+	{
+		if (error != nullptr) *error = tr("Failed to parse job:\r\n%1\r\n%2").arg(path, parseError.errorString());
+		return false;
+	}
+
+	return fromJson(document.object(), job, error);
+}
+
+// Dry runs only need the template dimensions, which local files provide from their header.
+QSize ExportJob::templateSize(QString* error) const
+{
+	const QUrl& url = m_data.source().templateUrl();
+
+	if (ImageCache::instance()->contains(url))
+	{
+		return ImageCache::instance()->sourceSize(url);
+	}
+
+	if (!RemoteFetcher::isRemote(url))
+	{
+		QImageReader reader(url.isLocalFile() ? url.toLocalFile() : ":" + url.path());
+
+		if (reader.size().isValid())
+		{
+			return reader.size();
+		}
+	}
+
+	return ImageCache::instance()->image(url, error).size();
+}
+
+QStringList ExportJob::inputKeys() const
+{
+	QStringList keys { "template" };
+
+	for (const auto& face : m_data.faces())
+	{
+		if (face.enabled())
+		{
+			keys.append(face.face());
+		}
+	}
+
+	return keys;
+}
+
+QUrl ExportJob::inputUrl(const QString& key) const
+{
+	FaceData::FaceIndex index = FaceData::indexFromName(key);
+
+	return index == FaceData::INVALID ? m_data.source().templateUrl() : m_data.face(index).faceImageUrl();
+}
+
+// The memo first, then the store another process may have filled, then decoding and processing the texture.
+QImage ExportJob::processedFace(const FaceData& face, bool* mapped, QString* error, const CancellationToken& token)
+{
+	QString storeKey = ProcessedStore::instance()->key(face, token);
+
+	if (!storeKey.isEmpty())
+	{
+		QMutexLocker lock(&processedMutex);
+
+		if (const Processed* processed = processedFaces.object(storeKey))
+		{
+			*mapped = processed->mapped;
+			return processed->image;
+		}
+	}
+
+	QImage image = ProcessedStore::instance()->find(storeKey);
+	*mapped = !image.isNull();
+
+	if (image.isNull())
+	{
+		image = ImageCache::instance()->image(face.faceImageUrl(), error, token);
+
+		if (image.isNull())
+		{
+			return QImage();
+		}
+
+		FaceProcessor::process(face, image, token);
+
+		if (image.isNull())
+		{
+			if (error != nullptr) *error = tr("Canceled while processing the faces.");
+			return QImage();
+		}
+
+		ProcessedStore::instance()->insert(storeKey, image);
+	}
+
+	if (!storeKey.isEmpty())
+	{
+		QMutexLocker lock(&processedMutex);
+		processedFaces.insert(storeKey, new Processed { image, *mapped }, std::max(1, int(image.sizeInBytes() / 1024)));
+	}
+
+	return image;
+}
+
+// Large faces are kept compressed one face cell per block, the compositor unpacks the cells it draws. Faces mapped from
+// the ProcessedStore are left alone, they cost no memory to begin with.
+void ExportJob::compressLargeFaces(Inputs& inputs, const QStringList& keys, const QSet<QString>& mapped, const ExportData& data,
+								   const CancellationToken& token)
+{
+	// Faces sharing a processed image share its compressed copy too.
+	QHash<qint64, CompressedImage> shared;
+
+	for (const QString& key : keys)
+	{
+		if (token.isCanceled())
+		{
+			break;
+		}
+
+		FaceData::FaceIndex index = FaceData::indexFromName(key);
+		auto it = inputs.images.find(key);
+
+		if (index == FaceData::INVALID || it == inputs.images.end() || mapped.contains(key) || !CompressedImage::worthCompressing(*it))
+		{
+			continue;
+		}
+
+		if (!shared.contains(it->cacheKey()))
+		{
+			shared[it->cacheKey()] = CompressedImage::compress(*it, data.face(index).faceRect().size());
+		}
+
+		inputs.compressed[key] = shared[it->cacheKey()];
+		inputs.images.erase(it);
+	}
+}
+
+bool ExportJob::loadImages(Inputs& inputs, const QStringList& keys, const TileRenderer::Callbacks& callbacks, QString* error) const
+{
+	const CancellationToken token = callbacks.token;
+	const QStringList pending = keys.isEmpty() ? inputKeys() : keys;
+
+	if (callbacks.status)
+	{
+		callbacks.status(tr("Processing images..."));
+	}
+
+	QSet<QString> mapped;
+	int count = 0;
+
+	for (const QString& key : pending)
+	{
+		if (token.isCanceled())
+		{
+			break;
+		}
+
+		FaceData::FaceIndex index = FaceData::indexFromName(key);
+		QString message;
+		QImage image;
+
+		if (index == FaceData::INVALID)
+		{
+			image = ImageCache::instance()->image(inputUrl(key), &message, token);
+		}
+		else
+		{
+			bool stored = false;
+			image = processedFace(m_data.face(index), &stored, &message, token);
+
+			if (stored)
+			{
+				mapped.insert(key);
+			}
+		}
+
+		if (token.isCanceled())
+		{
+			break;
+		}
+
+		if (image.isNull())
+		{
+			if (error != nullptr) *error = message.isEmpty() ? tr("An image could not be loaded from:\r\n'%1'").arg(inputUrl(key).toString()) : message;
+			return false;
+		}
+
+		inputs.images[key] = image;
+		inputs.compressed.remove(key);
+
+		++count;
+
+		if (callbacks.status)
+		{
+			callbacks.status(tr("%1/%2 images processed...").arg(count).arg(pending.count()));
+		}
+
+		if (callbacks.progress)
+		{
+			callbacks.progress(qreal(count) / pending.count());
+		}
+	}
+
+	if (!token.isCanceled())
+	{
+		if (callbacks.status)
+		{
+			callbacks.status(tr("Compressing images..."));
+		}
+
+		compressLargeFaces(inputs, pending, mapped, m_data, token);
+	}
+
+	if (token.isCanceled())
+	{
+		if (error != nullptr) *error = tr("Canceled while processing the faces.");
+		return false;
+	}
+
+	return true;
+}
+
+bool ExportJob::loadVariantImages(const QVector<ExportJob>& jobs, QVector<Inputs>& inputs, const TileRenderer::Callbacks& callbacks,
+								  QString* error)
+{
+	const CancellationToken token = callbacks.token;
+
+	inputs = QVector<Inputs>(jobs.count());
+
+	if (callbacks.status)
+	{
+		callbacks.status(tr("Processing images..."));
+	}
+
+	QStringList keys;
+
+	for (const ExportJob& job : jobs)
+	{
+		for (const QString& key : job.inputKeys())
+		{
+			if (key != "template" && !keys.contains(key))
+			{
+				keys.append(key);
+			}
+		}
+	}
+
+	auto area = [](const QSize& size) { return qint64(size.width()) * size.height(); };
+
+	QHash<QUrl, QImage> sources;
+	QHash<QString, QImage> intermediates; // by FaceProcessor::shapeKey
+	int count = 0;
+
+	for (const QString& key : keys)
+	{
+		FaceData::FaceIndex index = FaceData::indexFromName(key);
+		QHash<QString, FaceData> largest;
+
+		for (const ExportJob& job : jobs)
+		{
+			const FaceData face = job.m_data.face(index);
+
+			if (face.enabled())
+			{
+				QString shape = FaceProcessor::shapeKey(face);
+				auto current = largest.constFind(shape);
+
+				if (current == largest.constEnd() || area(FaceProcessor::targetSize(face)) > area(FaceProcessor::targetSize(*current)))
+				{
+					largest[shape] = face;
+				}
+			}
+		}
+
+		for (auto shape = largest.constBegin(); shape != largest.constEnd(); ++shape)
+		{
+			if (token.isCanceled())
+			{
+				break;
+			}
+
+			if (intermediates.contains(shape.key()))
+			{
+				continue;
+			}
+
+			const QUrl& url = shape->faceImageUrl();
+
+			if (!sources.contains(url))
+			{
+				QString message;
+				sources[url] = ImageCache::instance()->image(url, &message, token);
+
+				if (token.isCanceled())
+				{
+					break;
+				}
+
+				if (sources[url].isNull())
+				{
+					if (error != nullptr) *error = message.isEmpty() ? tr("An image could not be loaded from:\r\n'%1'").arg(url.toString()) : message;
+					return false;
+				}
+			}
+
+			intermediates[shape.key()] = shape->resizeSource() ?
+						FaceProcessor::resample(*shape, sources[url], FaceProcessor::targetSize(*shape), token) : sources[url];
+		}
+
+		if (token.isCanceled())
+		{
+			break;
+		}
+
+		++count;
+
+		if (callbacks.status)
+		{
+			callbacks.status(tr("%1/%2 images processed...").arg(count).arg(keys.count()));
+		}
+
+		if (callbacks.progress)
+		{
+			callbacks.progress(qreal(count) / keys.count());
+		}
+	}
+
+	for (int i = 0; i < jobs.count() && !token.isCanceled(); ++i)
+	{
+		QString message;
+		const QUrl& templateUrl = jobs[i].m_data.source().templateUrl();
+
+		inputs[i].images["template"] = ImageCache::instance()->image(templateUrl, &message, token);
+
+		if (inputs[i].images["template"].isNull() && !token.isCanceled())
+		{
+			if (error != nullptr) *error = message.isEmpty() ? tr("An image could not be loaded from:\r\n'%1'").arg(templateUrl.toString()) : message;
+			return false;
+		}
+
+		QStringList faces;
+
+		for (const QString& key : jobs[i].inputKeys())
+		{
+			FaceData::FaceIndex index = FaceData::indexFromName(key);
+
+			if (index == FaceData::INVALID)
+			{
+				continue;
+			}
+
+			const FaceData face = jobs[i].m_data.face(index);
+			QImage intermediate = intermediates.value(FaceProcessor::shapeKey(face));
+			QSize size = FaceProcessor::targetSize(face);
+
+			inputs[i].images[key] = !face.resizeSource() || intermediate.size() == size ? intermediate : FaceProcessor::scaled(intermediate, size, token);
+			faces.append(key);
+		}
+
+		compressLargeFaces(inputs[i], faces, QSet<QString>(), jobs[i].m_data, token);
+	}
+
+	if (token.isCanceled())
+	{
+		if (error != nullptr) *error = tr("Canceled while processing the faces.");
+		return false;
+	}
+
+	return true;
+}
+
+bool ExportJob::prepareDirectories(const QStringList& directories, const ExportPlan::Estimate& estimate, QString* error)
+{
+	for (const QString& directory : directories)
+	{
+		if (!QDir().mkpath(directory))
+		{
+			if (error != nullptr) *error = tr("Failed to create the output directory:\r\n%1").arg(directory);
+			return false;
+		}
+
+		QStorageInfo storage(directory);
+
+		if (storage.isValid() && storage.bytesAvailable() < estimate.outputBytes)
+		{
+			if (error != nullptr) *error = tr("Not enough disk space, about %1 are needed in:\r\n%2").arg(QLocale().formattedDataSize(estimate.outputBytes), directory);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Everything after loading: checks the destination, renders and calibrates the estimates.
+bool ExportJob::render(const ExportPlan& plan, const QVector<int>& selection, const Inputs& inputs, const QStringList& directories,
+					   const TileRenderer::Callbacks& callbacks, TileRenderer::Report& report, QString* error) const
+{
+	ExportPlan::Calibration calibration = ExportPlan::Calibration::load(m_options.optimize);
+	ExportPlan::Estimate estimate = plan.estimate(selection, calibration);
+
+	// A sink takes the tiles in memory, the directories are not touched then.
+	if (!prepareDirectories(callbacks.sink ? QStringList() : directories, estimate, error))
+	{
+		return false;
+	}
+
+	TileRenderer renderer(plan);
+	renderer.setCompressedFaces(inputs.compressed);
+
+	if (!inputs.templateBands.isNull())
+	{
+		renderer.setTemplateBands(inputs.templateBands);
+	}
+
+	if (callbacks.status)
+	{
+		callbacks.status(tr("Starting..."));
+	}
+
+	report = renderer.render(inputs.images, directories, m_options, selection, estimate.threads, callbacks);
+
+	if (report.failed > 0)
+	{
+		if (error != nullptr) *error = tr("%1 tiles could not be written to:\r\n%2").arg(report.failed).arg(directories.join("\r\n"));
+		return false;
+	}
+
+	if (!callbacks.token.isCanceled())
+	{
+		calibration.record(report.pixelWork, report.elapsed, estimate.threads, report.writtenBytes);
+		calibration.save(m_options.optimize);
+	}
+
+	return true;
+}
+
+bool ExportJob::render(const ExportPlan& plan, const QVector<int>& selection, const QStringList& directories,
+					   const TileRenderer::Callbacks& callbacks, TileRenderer::Report& report, QString* error) const
+{
+	// Checked before the decoding too, a full disk is reported without waiting for it.
+	ExportPlan::Estimate estimate = plan.estimate(selection, ExportPlan::Calibration::load(m_options.optimize));
+
+	if (!prepareDirectories(callbacks.sink ? QStringList() : directories, estimate, error))
+	{
+		return false;
+	}
+
+	// The progress reported is the rendering's.
+	TileRenderer::Callbacks loading = callbacks;
+	loading.progress = nullptr;
+
+	Inputs inputs;
+
+	if (!loadImages(inputs, QStringList(), loading, error))
+	{
+		// Canceled before rendering, which is not an error.
+		if (callbacks.token.isCanceled())
+		{
+			report = TileRenderer::Report();
+			report.cancelLatency = callbacks.token.sinceCancel();
+			return true;
+		}
+
+		return false;
+	}
+
+	return render(plan, selection, inputs, directories, callbacks, report, error);
+}
+
+bool ExportJob::run(const QStringList& directories, const TileRenderer::Callbacks& callbacks, TileRenderer::Report& report,
+					QString* error) const
+{
+	QSize size = templateSize(error);
+
+	if (!size.isValid())
+	{
+		return false;
+	}
+
+	ExportPlan plan = ExportPlan::compile(m_data, size);
+
+	return render(plan, plan.select(ShardSpec()), directories, callbacks, report, error);
+}
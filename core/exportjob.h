@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef EXPORTJOB_H
+#define EXPORTJOB_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+
+#include "waifu2ugccore.h"
+#include "compressedimage.h"
+#include "exportdata.h"
+#include "pngbandencoder.h"
+#include "tileoptimizer.h"
+#include "tilerenderer.h"
+
+// An export as run by the window, the command line and the render service.
+class WAIFU2UGC_CORE_EXPORT ExportJob
+{
+	Q_DECLARE_TR_FUNCTIONS(ExportJob)
+
+public:
+	// The decoded template and processed faces of a job, keyed "template" and by face name. Faces too large to keep
+	// decoded are held compressed instead, unless the ProcessedStore maps them from disk.
+	struct Inputs
+	{
+		QHash<QString, QImage> images;
+		QHash<QString, CompressedImage> compressed;
+
+		// Set by callers rendering the same template several times, see TileRenderer::setTemplateBands().
+		PngBandEncoder templateBands;
+	};
+
+	ExportData& data()								{ return m_data; }
+	const ExportData& data() const					{ return m_data; }
+
+	TileOptimizer::Options& options()				{ return m_options; }
+	const TileOptimizer::Options& options() const	{ return m_options; }
+
+	QJsonObject toJson() const;
+	static bool fromJson(const QJsonObject& json, ExportJob& job, QString* error = nullptr);
+	static bool load(const QString& path, ExportJob& job, QString* error = nullptr);
+
+	QSize templateSize(QString* error = nullptr) const;
+
+	// Loads the given inputs, all of them when empty, replacing what inputs held for them. Progress goes from 0 to 1
+	// over the inputs; a cancel fails the load.
+	bool loadImages(Inputs& inputs, const QStringList& keys, const TileRenderer::Callbacks& callbacks, QString* error = nullptr) const;
+
+	// The inputs of jobs differing only in their template and face rects: every texture is decoded once and resampled
+	// once per shape, at the largest size a job of that shape needs, the others scale that intermediate down.
+	static bool loadVariantImages(const QVector<ExportJob>& jobs, QVector<Inputs>& inputs, const TileRenderer::Callbacks& callbacks,
+								  QString* error = nullptr);
+
+	// Creates the directories and checks each has room for the estimated output.
+	static bool prepareDirectories(const QStringList& directories, const ExportPlan::Estimate& estimate, QString* error = nullptr);
+
+	bool render(const ExportPlan& plan, const QVector<int>& selection, const Inputs& inputs, const QStringList& directories,
+				const TileRenderer::Callbacks& callbacks, TileRenderer::Report& report, QString* error = nullptr) const;
+
+	// Loads every input, then renders them as above.
+	bool render(const ExportPlan& plan, const QVector<int>& selection, const QStringList& directories,
+				const TileRenderer::Callbacks& callbacks, TileRenderer::Report& report, QString* error = nullptr) const;
+
+	// Every tile of the job, into the directories or the callbacks' sink.
+	bool run(const QStringList& directories, const TileRenderer::Callbacks& callbacks, TileRenderer::Report& report,
+			 QString* error = nullptr) const;
+
+private:
+	QStringList inputKeys() const;
+	QUrl inputUrl(const QString& key) const;
+
+	static QImage processedFace(const FaceData& face, bool* mapped, QString* error, const CancellationToken& token);
+	static void compressLargeFaces(Inputs& inputs, const QStringList& keys, const QSet<QString>& mapped, const ExportData& data,
+								   const CancellationToken& token);
+
+private:
+	ExportData m_data;
+	TileOptimizer::Options m_options;
+};
+
+#endif // EXPORTJOB_H
@@ -0,0 +1,368 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "exportplan.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QSettings>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// Wall time is turned into thread time, which is what stays the same when the next export runs on another thread count.
+void ExportPlan::Calibration::record(qint64 pixelWork, qint64 nanoseconds, int threads, qint64 bytes)
+{
+	if (pixelWork <= 0 || nanoseconds <= 0)
+	{
+		return;
+	}
+
+	double measuredTime = double(nanoseconds) * std::max(1, threads) / pixelWork;
+	double measuredBytes = double(bytes) / pixelWork;
+
+	// The first run replaces the defaults, later ones are averaged so a single slow export does not dominate.
+	double weight = samples == 0 ? 1.0 : 0.5;
+
+	nanosecondsPerPixel += weight * (measuredTime - nanosecondsPerPixel);
+	bytesPerPixel += weight * (measuredBytes - bytesPerPixel);
+
+	++samples;
+}
+
+ExportPlan::Calibration ExportPlan::Calibration::load(bool optimized)
+{
+	Calibration calibration;
+
+	QSettings settings;
+	settings.beginGroup(optimized ? "calibration/optimized" : "calibration/plain");
+
+	calibration.nanosecondsPerPixel = settings.value("nanosecondsPerPixel", calibration.nanosecondsPerPixel).toDouble();
+	calibration.bytesPerPixel = settings.value("bytesPerPixel", calibration.bytesPerPixel).toDouble();
+	calibration.samples = settings.value("samples", 0).toInt();
+
+	return calibration;
+}
+
+void ExportPlan::Calibration::save(bool optimized) const
+{
+	QSettings settings;
+	settings.beginGroup(optimized ? "calibration/optimized" : "calibration/plain");
+
+	settings.setValue("nanosecondsPerPixel", nanosecondsPerPixel);
+	settings.setValue("bytesPerPixel", bytesPerPixel);
+	settings.setValue("samples", samples);
+}
+
+QString ExportPlan::Estimate::text() const
+{
+	QLocale locale;
+
+	return tr("%1 tiles, %2 megapixels of work, about %3 on disk and %4 s on %5 threads%6.")
+			.arg(tiles)
+			.arg(pixelWork / 1000000.0, 0, 'f', 1)
+			.arg(locale.formattedDataSize(outputBytes))
+			.arg(seconds, 0, 'f', 1)
+			.arg(threads)
+			.arg(calibrated ? QString() : " " + tr("(uncalibrated)"));
+}
+
+// Walks the voxels in the same order the exporter always did, so tile ordinals and file names are stable.
+ExportPlan ExportPlan::compile(const ExportData& data, const QSize& tileSize)
+{
+	ExportPlan plan;
+	plan.m_data = data;
+	plan.m_tileSize = tileSize;
+
+	int xSize = std::max(1, data.getXAxisSize());
+	int ySize = std::max(1, data.getYAxisSize());
+	int zSize = std::max(1, data.getZAxisSize());
+
+	QMap< FaceData::FaceIndex, std::function<bool(int, int, int)> > visible {
+		{ FaceData::FRONT,  [     ](int, int, int z) { return z == 0; } },
+		{ FaceData::TOP,    [     ](int, int y, int) { return y == 0; } },
+		{ FaceData::RIGHT,  [xSize](int x, int, int) { return x == xSize - 1; } },
+		{ FaceData::BACK,   [zSize](int, int, int z) { return z == zSize - 1; } },
+		{ FaceData::BOTTOM, [ySize](int, int y, int) { return y == ySize - 1; } },
+		{ FaceData::LEFT,   [     ](int x, int, int) { return x == 0; } }
+	};
+
+	QMap< FaceData::FaceIndex, std::function<QPoint(int, int, int)> > translate {
+		{ FaceData::FRONT,  [            ](int x, int y, int) { return QPoint(x, y); } },
+		{ FaceData::TOP,    [       zSize](int x, int, int z) { return QPoint(x, zSize - 1 - z); } },
+		{ FaceData::RIGHT,  [            ](int, int y, int z) { return QPoint(z, y); } },
+		{ FaceData::BACK,   [xSize       ](int x, int y, int) { return QPoint(xSize - 1 - x, y); } },
+		{ FaceData::BOTTOM, [xSize, zSize](int x, int, int z) { return QPoint(xSize - 1 - x, zSize - 1 - z); } },
+		{ FaceData::LEFT,   [       zSize](int, int y, int z) { return QPoint(zSize - 1 - z, y); } }
+	};
+
+	for (int x = 0; x < xSize; ++x)
+	{
+		for (int y = 0; y < ySize; ++y)
+		{
+			for (int z = 0; z < zSize; ++z)
+			{
+				Tile tile;
+
+				for (const auto& face : data.faces())
+				{
+					if (face.enabled() && visible[face.index()](x, y, z))
+					{
+						auto pos2d = translate[face.index()](x, y, z);
+
+						if (pos2d.x() < face.horizontalCount() && pos2d.y() < face.verticalCount())
+						{
+							if (tile.mainIndex == FaceData::INVALID)
+							{
+								tile.mainIndex = face.index();
+								tile.mainPoint = pos2d;
+							}
+
+							tile.blits.append({ face.index(), pos2d });
+						}
+					}
+				}
+
+				if (tile.mainIndex != FaceData::INVALID)
+				{
+					tile.fileName = QString("%5-%1%2%3-%4-%2,%3.png")
+									.arg(tile.mainIndex)
+									.arg(tile.mainPoint.x() + 1)
+									.arg(tile.mainPoint.y() + 1)
+									.arg(data.faces()[tile.mainIndex].text())
+									.arg("waifu2ugc");
+
+					plan.m_tiles.append(tile);
+				}
+			}
+		}
+	}
+
+	return plan;
+}
+
+QVector<int> ExportPlan::select(const ShardSpec& shard) const
+{
+	QVector<int> selection;
+
+	for (int i = 0; i < m_tiles.count(); ++i)
+	{
+		if (shard.contains(i))
+		{
+			selection.append(i);
+		}
+	}
+
+	return selection;
+}
+
+// The tiles showing any of the given faces, i.e. the ones to redo when those inputs change.
+QVector<int> ExportPlan::select(const QSet<FaceData::FaceIndex>& faces) const
+{
+	QVector<int> selection;
+
+	for (int i = 0; i < m_tiles.count(); ++i)
+	{
+		for (const Blit& blit : m_tiles[i].blits)
+		{
+			if (faces.contains(blit.face))
+			{
+				selection.append(i);
+				break;
+			}
+		}
+	}
+
+	return selection;
+}
+
+// Copying the template and encoding touch the whole tile, each blit touches its face rect once more.
+qint64 ExportPlan::pixelWork(const Tile& tile) const
+{
+	qint64 work = qint64(m_tileSize.width()) * m_tileSize.height();
+
+	for (const Blit& blit : tile.blits)
+	{
+		const QRect& rect = m_data.faces().constFind(blit.face)->faceRect();
+		work += qint64(rect.width()) * rect.height();
+	}
+
+	return work;
+}
+
+ExportPlan::Estimate ExportPlan::estimate(const QVector<int>& selection, const Calibration& calibration) const
+{
+	Estimate estimate;
+
+	for (int i : selection)
+	{
+		++estimate.tiles;
+		estimate.pixelWork += pixelWork(m_tiles[i]);
+	}
+
+	estimate.outputBytes = qint64(estimate.pixelWork * calibration.bytesPerPixel);
+	estimate.calibrated = calibration.samples > 0;
+
+	double threadSeconds = estimate.pixelWork * calibration.nanosecondsPerPixel / 1e9;
+
+	// Each thread keeps a composed tile and its encoding in memory, and should get enough work to pay for starting it.
+	qint64 tileBytes = qint64(m_tileSize.width()) * m_tileSize.height() * 4 + (estimate.tiles > 0 ? estimate.outputBytes / estimate.tiles : 0);
+	int threads = std::min(QThread::idealThreadCount(), estimate.tiles);
+
+	threads = int(std::min<qint64>(threads, m_memoryBudget / std::max<qint64>(1, tileBytes)));
+	threads = int(std::min<double>(threads, std::ceil(threadSeconds / m_minimumThreadSeconds)));
+
+	estimate.threads = std::max(1, threads);
+	estimate.seconds = threadSeconds / estimate.threads;
+
+	return estimate;
+}
+
+QJsonObject ExportPlan::toJson() const
+{
+	QJsonArray tiles;
+
+	for (const Tile& tile : m_tiles)
+	{
+		QJsonArray blits;
+
+		for (const Blit& blit : tile.blits)
+		{
+			blits.append(QJsonObject {
+				{ "face", FaceData::nameFromIndex(blit.face) },
+				{ "x", blit.position.x() },
+				{ "y", blit.position.y() }
+			});
+		}
+
+		tiles.append(QJsonObject {
+			{ "file", tile.fileName },
+			{ "face", FaceData::nameFromIndex(tile.mainIndex) },
+			{ "x", tile.mainPoint.x() },
+			{ "y", tile.mainPoint.y() },
+			{ "blits", blits }
+		});
+	}
+
+	return QJsonObject {
+		{ "job", m_data.toJson() },
+		{ "tileSize", QJsonArray { m_tileSize.width(), m_tileSize.height() } },
+		{ "tiles", tiles }
+	};
+}
+
+bool ExportPlan::fromJson(const QJsonObject& json, ExportPlan& plan, QString* error)
+{
+	plan = ExportPlan();
+
+	if (!ExportData::fromJson(json.value("job").toObject(), plan.m_data, error))
+	{
+		return false;
+	}
+
+	const QJsonArray tileSize = json.value("tileSize").toArray();
+	plan.m_tileSize = QSize(tileSize.at(0).toInt(), tileSize.at(1).toInt());
+
+	if (plan.m_tileSize.isEmpty())
+	{
+		if (error != nullptr) *error = tr("The plan has no tile size.");
+		return false;
+	}
+
+	// The renderer and the tile gallery index faces and their cells straight from the tiles.
+	const QRect bounds(QPoint(0, 0), plan.m_tileSize);
+	const auto& faces = plan.m_data.faces();
+
+	auto validCell = [&faces, &bounds](FaceData::FaceIndex index, const QPoint& cell) {
+		auto face = faces.constFind(index);
+
+		return face != faces.constEnd() && face->enabled() && bounds.contains(face->faceRect()) &&
+			   cell.x() >= 0 && cell.y() >= 0 && cell.x() < face->horizontalCount() && cell.y() < face->verticalCount();
+	};
+
+	for (const auto& tileValue : json.value("tiles").toArray())
+	{
+		const QJsonObject object = tileValue.toObject();
+
+		Tile tile;
+		tile.fileName = object.value("file").toString();
+		tile.mainIndex = FaceData::indexFromName(object.value("face").toString());
+		tile.mainPoint = QPoint(object.value("x").toInt(), object.value("y").toInt());
+
+		for (const auto& blitValue : object.value("blits").toArray())
+		{
+			const QJsonObject blit = blitValue.toObject();
+			tile.blits.append({ FaceData::indexFromName(blit.value("face").toString()), QPoint(blit.value("x").toInt(), blit.value("y").toInt()) });
+
+			if (tile.blits.last().face == FaceData::INVALID)
+			{
+				if (error != nullptr) *error = tr("Tile '%1' blits an unknown face.").arg(tile.fileName);
+				return false;
+			}
+
+			if (!validCell(tile.blits.last().face, tile.blits.last().position))
+			{
+				if (error != nullptr) *error = tr("Tile '%1' blits outside of its face or the template.").arg(tile.fileName);
+				return false;
+			}
+		}
+
+		if (tile.mainIndex == FaceData::INVALID || tile.fileName.isEmpty() || tile.blits.isEmpty() ||
+				!validCell(tile.mainIndex, tile.mainPoint))
+		{
+			if (error != nullptr) *error = tr("The plan has an invalid tile.");
+			return false;
+		}
+
+		plan.m_tiles.append(tile);
+	}
+
+	return true;
+}
+
+bool ExportPlan::load(const QString& path, ExportPlan& plan, QString* error)
+{
+	QFile file(path);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		if (error != nullptr) *error = tr("Failed to open plan:\r\n%1\r\n%2").arg(path, file.errorString());
+		return false;
+	}
+
+	QJsonParseError parseError;
+	QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+	if (!document.isObject())
+	{
+		if (error != nullptr) *error = tr("Failed to parse plan:\r\n%1\r\n%2").arg(path, parseError.errorString());
+		return false;
+	}
+
+	return fromJson(document.object(), plan, error);
+}
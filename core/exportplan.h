@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef EXPORTPLAN_H
+#define EXPORTPLAN_H
+
+#include <QCoreApplication>
+#include <QJsonObject>
+#include <QSet>
+#include <QVector>
+
+#include "waifu2ugccore.h"
+#include "exportdata.h"
+#include "shardspec.h"
+
+// The tiles an export will produce, computed up front so it can be inspected, estimated and shared before rendering.
+class WAIFU2UGC_CORE_EXPORT ExportPlan
+{
+	Q_DECLARE_TR_FUNCTIONS(ExportPlan)
+
+public:
+	struct Blit
+	{
+		FaceData::FaceIndex face = FaceData::INVALID;
+		QPoint position;
+	};
+
+	struct Tile
+	{
+		FaceData::FaceIndex mainIndex = FaceData::INVALID;
+		QPoint mainPoint;
+		QString fileName;
+		QVector<Blit> blits;
+	};
+
+	// Thread time and output size per pixel of work, measured by previous exports on this machine.
+	struct Calibration
+	{
+		double nanosecondsPerPixel = 20.0;
+		double bytesPerPixel = 1.5;
+		int samples = 0;
+
+		// nanoseconds is the wall time of a render on the given number of threads.
+		void record(qint64 pixelWork, qint64 nanoseconds, int threads, qint64 bytes);
+
+		static Calibration load(bool optimized);
+		void save(bool optimized) const;
+	};
+
+	struct Estimate
+	{
+		int tiles = 0;
+		int threads = 1;
+
+		qint64 pixelWork = 0;
+		qint64 outputBytes = 0;
+
+		double seconds = 0.0;
+		bool calibrated = false;
+
+		QString text() const;
+	};
+
+	static ExportPlan compile(const ExportData& data, const QSize& tileSize);
+
+	const ExportData& data() const			{ return m_data; }
+	const QSize& tileSize() const			{ return m_tileSize; }
+	const QVector<Tile>& tiles() const		{ return m_tiles; }
+
+	QVector<int> select(const ShardSpec& shard) const;
+	QVector<int> select(const QSet<FaceData::FaceIndex>& faces) const;
+
+	qint64 pixelWork(const Tile& tile) const;
+	Estimate estimate(const QVector<int>& selection, const Calibration& calibration) const;
+
+	QJsonObject toJson() const;
+	static bool fromJson(const QJsonObject& json, ExportPlan& plan, QString* error = nullptr);
+	static bool load(const QString& path, ExportPlan& plan, QString* error = nullptr);
+
+private:
+	ExportData m_data;
+	QSize m_tileSize;
+	QVector<Tile> m_tiles;
+
+	static constexpr qint64 m_memoryBudget = qint64(1024) * 1024 * 1024; // tiles in flight, composed and encoded
+	static constexpr double m_minimumThreadSeconds = 0.05;
+};
+
+#endif // EXPORTPLAN_H
@@ -28,6 +28,7 @@
 #include <QString>
 #include <QRect>
 #include <QUrl>
+#include <QPolygonF>
 
 class FaceData
 {
@@ -81,6 +82,36 @@ public:
 	QRect& cropRect()					{ return m_cropRect; }
 	const QRect& cropRect() const		{ return m_cropRect; }
 
+	// Outline of the visible part of a non-rectangular face, in fractions of the face rect. Empty for rectangles.
+	QPolygonF& mask()					{ return m_mask; }
+	const QPolygonF& mask() const		{ return m_mask; }
+
+	static FaceIndex indexFromName(const QString& name)
+	{
+		if (name == "front")	return FRONT;
+		if (name == "top")		return TOP;
+		if (name == "right")	return RIGHT;
+		if (name == "back")		return BACK;
+		if (name == "bottom")	return BOTTOM;
+		if (name == "left")		return LEFT;
+
+		return INVALID;
+	}
+
+	static QString nameFromIndex(FaceIndex index)
+	{
+		switch (index)
+		{
+			case FRONT:		return "front";
+			case TOP:		return "top";
+			case RIGHT:		return "right";
+			case BACK:		return "back";
+			case BOTTOM:	return "bottom";
+			case LEFT:		return "left";
+			default:		return QString();
+		}
+	}
+
 	bool affectsXHorizontally() const	{ return m_index == FRONT || m_index == TOP   || m_index == BACK || m_index == BOTTOM; }
 	bool affectsXVertically() const		{ return false; }
 	bool affectsYHorizontally() const	{ return false; }
@@ -110,6 +141,8 @@ private:
 
 	QRect m_fitRect;
 	QRect m_cropRect;
+
+	QPolygonF m_mask;
 };
 
 #endif // FACEDATA_H
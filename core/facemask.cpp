@@ -0,0 +1,272 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "facemask.h"
+
+#include <QPainter>
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// x * a / 255 on all four channels at once, rounded like QPainter does.
+static inline quint32 byteMul(quint32 x, uint a)
+{
+	quint32 t = (x & 0xff00ff) * a;
+	t = ((t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+
+	x = ((x >> 8) & 0xff00ff) * a;
+	x = (x + ((x >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+
+	return x | t;
+}
+
+static inline quint32 sourceOver(quint32 source, quint32 destination)
+{
+	return source + byteMul(destination, 255 - qAlpha(source));
+}
+
+#ifdef __SSE2__
+static inline __m128i mul255(__m128i x, __m128i a)
+{
+	__m128i t = _mm_mullo_epi16(x, a);
+
+	return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), _mm_set1_epi16(128)), 8);
+}
+
+static inline __m128i alphas(__m128i pixels)
+{
+	pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+
+	return _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Four premultiplied pixels, each source scaled by its coverage in lo/hi (two pixels per register, broadcast to the channels).
+static inline __m128i sourceOver4(__m128i source, __m128i destination, __m128i coverageLo, __m128i coverageHi, bool covered)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(255);
+
+	__m128i sourceLo = _mm_unpacklo_epi8(source, zero);
+	__m128i sourceHi = _mm_unpackhi_epi8(source, zero);
+
+	if (!covered)
+	{
+		sourceLo = mul255(sourceLo, coverageLo);
+		sourceHi = mul255(sourceHi, coverageHi);
+	}
+
+	__m128i destinationLo = mul255(_mm_unpacklo_epi8(destination, zero), _mm_sub_epi16(full, alphas(sourceLo)));
+	__m128i destinationHi = mul255(_mm_unpackhi_epi8(destination, zero), _mm_sub_epi16(full, alphas(sourceHi)));
+
+	return _mm_packus_epi16(_mm_add_epi16(sourceLo, destinationLo), _mm_add_epi16(sourceHi, destinationHi));
+}
+#endif
+
+static void blendCovered(quint32* destination, const quint32* source, int length)
+{
+	int x = 0;
+
+#ifdef __SSE2__
+	const __m128i alphaMask = _mm_set1_epi32(int(0xff000000));
+
+	for (; x + 4 <= length; x += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x));
+		__m128i alpha = _mm_and_si128(pixels, alphaMask);
+
+		// Opaque and transparent runs are the common case inside a face, they need no arithmetic.
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xffff)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), pixels);
+		}
+		else if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) != 0xffff)
+		{
+			__m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + x));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), sourceOver4(pixels, target, __m128i(), __m128i(), true));
+		}
+	}
+#endif
+
+	for (; x < length; ++x)
+	{
+		destination[x] = sourceOver(source[x], destination[x]);
+	}
+}
+
+static void blendPartial(quint32* destination, const quint32* source, const uchar* coverage, int length)
+{
+	int x = 0;
+
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; x + 4 <= length; x += 4)
+	{
+		quint32 bytes;
+		std::memcpy(&bytes, coverage + x, sizeof(bytes));
+
+		__m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(bytes)), zero);
+		words = _mm_unpacklo_epi16(words, words);
+
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x));
+		__m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + x));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x),
+						 sourceOver4(pixels, target, _mm_unpacklo_epi32(words, words), _mm_unpackhi_epi32(words, words), false));
+	}
+#endif
+
+	for (; x < length; ++x)
+	{
+		destination[x] = sourceOver(byteMul(source[x], coverage[x]), destination[x]);
+	}
+}
+
+// Rasterizes the outline once with antialiasing and run length encodes the rows into empty, full and partial spans.
+FaceMask FaceMask::build(const QPolygonF& outline, const QSize& size)
+{
+	FaceMask mask;
+
+	if (outline.count() < 3 || size.isEmpty())
+	{
+		return mask;
+	}
+
+	QImage coverage(size, QImage::Format_Alpha8);
+	coverage.fill(0);
+
+	{
+		QPainter painter(&coverage);
+		painter.setRenderHint(QPainter::Antialiasing);
+		painter.setPen(Qt::NoPen);
+		painter.setBrush(Qt::black);
+		painter.scale(size.width(), size.height());
+		painter.drawPolygon(outline);
+	}
+
+	mask.m_size = size;
+	mask.m_rows.reserve(size.height() + 1);
+
+	for (int y = 0; y < size.height(); ++y)
+	{
+		const uchar* line = coverage.constScanLine(y);
+
+		mask.m_rows.append(mask.m_spans.count());
+
+		int x = 0;
+
+		while (x < size.width())
+		{
+			uchar value = line[x];
+			int start = x;
+
+			if (value == 0)
+			{
+				while (x < size.width() && line[x] == 0) ++x;
+				continue;
+			}
+
+			Span span;
+			span.x = start;
+
+			if (value == 255)
+			{
+				while (x < size.width() && line[x] == 255) ++x;
+			}
+			else
+			{
+				while (x < size.width() && line[x] != 0 && line[x] != 255) ++x;
+
+				span.coverage = mask.m_coverage.size();
+				mask.m_coverage.append(reinterpret_cast<const char*>(line + start), x - start);
+			}
+
+			span.length = x - start;
+			mask.m_spans.append(span);
+		}
+	}
+
+	mask.m_rows.append(mask.m_spans.count());
+
+	return mask;
+}
+
+bool FaceMask::isNull() const
+{
+	return m_size.isEmpty();
+}
+
+QSize FaceMask::size() const
+{
+	return m_size;
+}
+
+void FaceMask::blend(QImage& destination, const QPoint& position, const QImage& source, const QPoint& sourcePosition) const
+{
+	Q_ASSERT(destination.format() == QImage::Format_ARGB32_Premultiplied);
+	Q_ASSERT(source.format() == QImage::Format_ARGB32_Premultiplied);
+
+	int left = std::max(-position.x(), -sourcePosition.x());
+	int right = std::min(destination.width() - position.x(), source.width() - sourcePosition.x());
+
+	for (int y = 0; y < m_size.height(); ++y)
+	{
+		int targetY = position.y() + y;
+		int sourceY = sourcePosition.y() + y;
+
+		if (targetY < 0 || targetY >= destination.height() || sourceY < 0 || sourceY >= source.height())
+		{
+			continue;
+		}
+
+		quint32* target = reinterpret_cast<quint32*>(destination.scanLine(targetY)) + position.x();
+		const quint32* pixels = reinterpret_cast<const quint32*>(source.constScanLine(sourceY)) + sourcePosition.x();
+
+		for (int i = m_rows[y]; i < m_rows[y + 1]; ++i)
+		{
+			const Span& span = m_spans[i];
+
+			int start = std::max(span.x, left);
+			int end = std::min(span.x + span.length, right);
+
+			if (start >= end)
+			{
+				continue;
+			}
+
+			if (span.coverage < 0)
+			{
+				blendCovered(target + start, pixels + start, end - start);
+			}
+			else
+			{
+				const uchar* coverage = reinterpret_cast<const uchar*>(m_coverage.constData()) + span.coverage + (start - span.x);
+				blendPartial(target + start, pixels + start, coverage, end - start);
+			}
+		}
+	}
+}
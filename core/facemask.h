@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef FACEMASK_H
+#define FACEMASK_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QPolygonF>
+#include <QSize>
+#include <QVector>
+
+#include "waifu2ugccore.h"
+
+// Coverage of a non-rectangular face, kept as runs per row so compositing only touches the partially covered edge pixels
+// with the coverage multiply and skips the outside entirely.
+class WAIFU2UGC_CORE_EXPORT FaceMask
+{
+public:
+	struct Span
+	{
+		int x = 0;
+		int length = 0;
+		int coverage = -1; // offset of the per pixel coverage, -1 when fully covered
+	};
+
+	static FaceMask build(const QPolygonF& outline, const QSize& size);
+
+	bool isNull() const;
+	QSize size() const;
+
+	// Both images must be Format_ARGB32_Premultiplied.
+	void blend(QImage& destination, const QPoint& position, const QImage& source, const QPoint& sourcePosition) const;
+
+private:
+	QSize m_size;
+
+	QVector<int> m_rows;
+	QVector<Span> m_spans;
+	QByteArray m_coverage;
+};
+
+#endif // FACEMASK_H
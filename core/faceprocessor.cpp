@@ -0,0 +1,194 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "faceprocessor.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QMutex>
+#include <QPainter>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+
+// Values match TemplateFace::AspectRatioAction.
+static constexpr int fitAction = 0;
+static constexpr int cropAction = 1;
+
+QSize FaceProcessor::targetSize(const FaceData& face)
+{
+	return QSize(face.faceRect().width() * face.horizontalCount(), face.faceRect().height() * face.verticalCount());
+}
+
+// Faces with the same key get the same processed image, wherever they sit on the template.
+QString FaceProcessor::key(const FaceData& face)
+{
+	QStringList parts { face.faceImageUrl().toString() };
+
+	if (face.resizeSource())
+	{
+		QSize size = targetSize(face);
+		parts.append(QString("%1x%2").arg(size.width()).arg(size.height()));
+
+		if (face.preserveAspectRatio())
+		{
+			QRect rect = face.aspectRatioAction() == fitAction ? face.fitRect() : face.cropRect();
+			parts.append(QString("%1:%2,%3,%4,%5").arg(face.aspectRatioAction()).arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height()));
+		}
+	}
+
+	return parts.join('|');
+}
+
+// Faces with the same shape key resample to the same picture at different sizes, the smaller ones can be scaled down
+// from the largest without stretching it.
+QString FaceProcessor::shapeKey(const FaceData& face)
+{
+	QStringList parts { face.faceImageUrl().toString() };
+
+	if (face.resizeSource())
+	{
+		QSize size = targetSize(face);
+		int divisor = size.width();
+
+		for (int remainder = size.height(); remainder != 0; )
+		{
+			int next = divisor % remainder;
+			divisor = remainder;
+			remainder = next;
+		}
+
+		divisor = std::max(1, divisor);
+		parts.append(QString("%1:%2").arg(size.width() / divisor).arg(size.height() / divisor));
+
+		if (face.preserveAspectRatio())
+		{
+			QRect rect = face.aspectRatioAction() == fitAction ? face.fitRect() : face.cropRect();
+			parts.append(QString("%1:%2,%3,%4,%5").arg(face.aspectRatioAction()).arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height()));
+		}
+	}
+
+	return parts.join('|');
+}
+
+// Qt's smooth scaling is a single step that cannot stop part way, and its filter takes its phase from the whole image
+// so it cannot be split into bands either. Large scales run on their own pool instead while the caller waits on the
+// token; a canceled scale finishes in the background and its result is dropped.
+static constexpr qint64 inlineScalePixels = 1024 * 1024;
+static constexpr int scalePollInterval = 10; // milliseconds
+
+namespace
+{
+	struct ScaleState
+	{
+		QMutex mutex;
+		QWaitCondition done;
+		QImage result;
+		bool finished = false;
+	};
+}
+
+static QThreadPool* scalingPool()
+{
+	static QThreadPool pool;
+	return &pool;
+}
+
+QImage FaceProcessor::scaled(const QImage& image, const QSize& size, const CancellationToken& token)
+{
+	if (token.isCanceled())
+	{
+		return QImage();
+	}
+
+	qint64 pixels = std::max(qint64(image.width()) * image.height(), qint64(size.width()) * size.height());
+
+	if (pixels < inlineScalePixels)
+	{
+		return image.scaled(size, Qt::AspectRatioMode::IgnoreAspectRatio, Qt::TransformationMode::SmoothTransformation);
+	}
+
+	QSharedPointer<ScaleState> state(new ScaleState);
+
+	QtConcurrent::run(scalingPool(), [state, image, size]() {
+		QImage result = image.scaled(size, Qt::AspectRatioMode::IgnoreAspectRatio, Qt::TransformationMode::SmoothTransformation);
+
+		QMutexLocker lock(&state->mutex);
+		state->result = result;
+		state->finished = true;
+		state->done.wakeAll();
+	});
+
+	QMutexLocker lock(&state->mutex);
+
+	while (!state->finished)
+	{
+		if (token.isCanceled())
+		{
+			return QImage();
+		}
+
+		state->done.wait(&state->mutex, scalePollInterval);
+	}
+
+	return token.isCanceled() ? QImage() : state->result;
+}
+
+void FaceProcessor::process(const FaceData& face, QImage& image, const CancellationToken& token)
+{
+	if (face.resizeSource())
+	{
+		image = resample(face, image, targetSize(face), token);
+	}
+}
+
+// The fit or crop of process() followed by one resample to the given size, which may differ from the face's own
+// target so several template variants can derive their faces from the same intermediate.
+QImage FaceProcessor::resample(const FaceData& face, const QImage& image, const QSize& size, const CancellationToken& token)
+{
+	if (face.preserveAspectRatio())
+	{
+		if (face.aspectRatioAction() == fitAction)
+		{
+			QImage frame(face.fitRect().size(), QImage::Format_ARGB32);
+			frame.fill(Qt::transparent);
+
+			QPainter painter(&frame);
+			painter.drawImage(face.fitRect().topLeft(), image, image.rect(), Qt::NoFormatConversion);
+			painter.end();
+
+			return scaled(frame, size, token);
+		}
+		else if (face.aspectRatioAction() == cropAction)
+		{
+			return scaled(image.copy(face.cropRect()), size, token);
+		}
+
+		return image;
+	}
+
+	return scaled(image, size, token);
+}
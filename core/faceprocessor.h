@@ -0,0 +1,49 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef FACEPROCESSOR_H
+#define FACEPROCESSOR_H
+
+#include <QImage>
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+#include "facedata.h"
+
+class WAIFU2UGC_CORE_EXPORT FaceProcessor
+{
+public:
+	static QSize targetSize(const FaceData& face);
+	static QString key(const FaceData& face);
+	static QString shapeKey(const FaceData& face);
+
+	static QImage scaled(const QImage& image, const QSize& size, const CancellationToken& token = CancellationToken());
+
+	// All three leave a null image when the token is canceled part way.
+	static void process(const FaceData& face, QImage& image, const CancellationToken& token = CancellationToken());
+	static QImage resample(const FaceData& face, const QImage& image, const QSize& size,
+						   const CancellationToken& token = CancellationToken());
+};
+
+#endif // FACEPROCESSOR_H
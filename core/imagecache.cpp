@@ -0,0 +1,390 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "imagecache.h"
+
+#include "remotefetcher.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+
+Q_GLOBAL_STATIC(ImageCache, globalImageCache)
+
+static QSize halved(const QSize& size)
+{
+	return QSize(std::max(1, (size.width() + 1) / 2), std::max(1, (size.height() + 1) / 2));
+}
+
+static bool satisfies(const QSize& size, const QSize& requested)
+{
+	return (requested.width() <= 0 || size.width() >= requested.width()) &&
+		   (requested.height() <= 0 || size.height() >= requested.height());
+}
+
+// Local files are reloaded when saved again, which long running exports and the service rely on.
+static QDateTime modifiedTime(const QUrl& url)
+{
+	return url.isLocalFile() ? QFileInfo(url.toLocalFile()).lastModified() : QDateTime();
+}
+
+static qint64 levelBytes(const QVector<QImage>& levels)
+{
+	qint64 bytes = 0;
+
+	for (const auto& level : levels)
+	{
+		bytes += level.sizeInBytes();
+	}
+
+	return bytes;
+}
+
+ImageCache::ImageCache(QObject* parent) : QObject(parent)
+{
+}
+
+ImageCache* ImageCache::instance()
+{
+	return globalImageCache();
+}
+
+QString ImageCache::providerName()
+{
+	return "waifu2ugc";
+}
+
+QUrl ImageCache::fromProviderId(const QString& id)
+{
+	return QUrl::fromEncoded(QByteArray::fromBase64(id.toLatin1(), QByteArray::Base64UrlEncoding));
+}
+
+QUrl ImageCache::providerUrl(const QUrl& url) const
+{
+	if (url.isEmpty())
+	{
+		return QUrl();
+	}
+
+	auto id = url.toEncoded().toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+
+	return QUrl(QString("image://%1/%2").arg(providerName(), QString::fromLatin1(id)));
+}
+
+QSize ImageCache::sourceSize(const QUrl& url) const
+{
+	QMutexLocker lock(&m_mutex);
+
+	return m_sourceSizes.value(url, m_thumbnailSizes.value(url));
+}
+
+// Rounds the painted size up to a power of two so resizing a view does not reload its image on every pixel.
+QSize ImageCache::requestSize(qreal width, qreal height) const
+{
+	auto bucket = [](qreal value) {
+		int size = 1;
+
+		while (size < value)
+		{
+			size *= 2;
+		}
+
+		return size;
+	};
+
+	return QSize(bucket(width), bucket(height));
+}
+
+bool ImageCache::contains(const QUrl& url) const
+{
+	QMutexLocker lock(&m_mutex);
+
+	return m_sourceSizes.contains(url);
+}
+
+void ImageCache::insert(const QUrl& url, const QImage& image)
+{
+	if (!image.isNull())
+	{
+		auto target = entry(url);
+
+		QMutexLocker entryLock(&target->mutex);
+
+		target->loaded = true;
+		target->error.clear();
+		target->sourceSize = image.size();
+		target->levels = { image };
+		target->modified = modifiedTime(url);
+
+		loaded(url, *target);
+	}
+}
+
+void ImageCache::remove(const QUrl& url)
+{
+	QMutexLocker lock(&m_mutex);
+
+	m_entries.remove(url);
+	m_sourceSizes.remove(url);
+	m_thumbnailSizes.remove(url);
+	m_bytes.remove(url);
+	m_recent.removeAll(url);
+}
+
+QImage ImageCache::image(const QUrl& url, QString* error, const CancellationToken& token)
+{
+	return level(url, QSize(), nullptr, error, token);
+}
+
+QImage ImageCache::level(const QUrl& url, const QSize& requestedSize, QSize* sourceSize, QString* error, const CancellationToken& token)
+{
+	auto target = entry(url);
+
+	QMutexLocker entryLock(&target->mutex);
+
+	if (!target->loaded && !token.isCanceled() && thumbnail(*target, url, requestedSize))
+	{
+		if (sourceSize != nullptr)
+		{
+			*sourceSize = target->thumbnail.sourceSize;
+		}
+
+		return target->thumbnail.image;
+	}
+
+	if (!target->loaded || target->modified != modifiedTime(url))
+	{
+		target->error.clear();
+		load(*target, url, token);
+	}
+
+	if (!target->error.isEmpty())
+	{
+		if (error != nullptr)
+		{
+			*error = target->error;
+		}
+
+		// Let the next request retry, the file may have been fixed in the meantime.
+		remove(url);
+
+		return QImage();
+	}
+
+	if (sourceSize != nullptr)
+	{
+		*sourceSize = target->sourceSize;
+	}
+
+	int index = 0;
+
+	if (requestedSize.width() > 0 || requestedSize.height() > 0)
+	{
+		QSize size = target->sourceSize;
+
+		while (size.width() > m_minimumLevelSize || size.height() > m_minimumLevelSize)
+		{
+			QSize next = halved(size);
+
+			if (!satisfies(next, requestedSize))
+			{
+				break;
+			}
+
+			size = next;
+			++index;
+		}
+	}
+
+	if (index >= target->levels.count())
+	{
+		while (index >= target->levels.count())
+		{
+			const QImage& previous = target->levels.last();
+			target->levels.append(previous.scaled(halved(previous.size()), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+		}
+
+		loaded(url, *target);
+	}
+
+	return target->levels[index];
+}
+
+QSharedPointer<ImageCache::Entry> ImageCache::entry(const QUrl& url)
+{
+	QMutexLocker lock(&m_mutex);
+
+	auto& target = m_entries[url];
+
+	if (target.isNull())
+	{
+		target.reset(new Entry);
+	}
+
+	m_recent.removeOne(url);
+	m_recent.append(url);
+
+	return target;
+}
+
+// A thumbnail of the whole source stands for it at any size, a smaller one only when it covers the request.
+bool ImageCache::thumbnail(Entry& entry, const QUrl& url, const QSize& requestedSize)
+{
+	if (requestedSize.width() <= 0 && requestedSize.height() <= 0)
+	{
+		return false;
+	}
+
+	if (!entry.thumbnailChecked || entry.modified != modifiedTime(url))
+	{
+		entry.thumbnailChecked = true;
+		entry.thumbnail = ThumbnailStore::instance()->find(url);
+		entry.modified = modifiedTime(url);
+	}
+
+	const ThumbnailStore::Thumbnail& thumbnail = entry.thumbnail;
+
+	if (thumbnail.isNull() || (thumbnail.image.size() != thumbnail.sourceSize && !satisfies(thumbnail.image.size(), requestedSize)))
+	{
+		return false;
+	}
+
+	{
+		QMutexLocker lock(&m_mutex);
+
+		m_thumbnailSizes[url] = thumbnail.sourceSize;
+		m_bytes[url] = thumbnail.image.sizeInBytes();
+	}
+
+	trim();
+
+	return true;
+}
+
+bool ImageCache::load(Entry& entry, const QUrl& url, const CancellationToken& token)
+{
+	QImage image;
+	QByteArray format;
+
+	if (token.isCanceled())
+	{
+		entry.error = tr("Canceled before loading:\r\n%1").arg(url.toString());
+	}
+	else if (!RemoteFetcher::isRemote(url))
+	{
+		QImageReader reader(url.isLocalFile() ? url.toLocalFile() : ":" + url.path());
+		format = reader.format();
+
+		if (!reader.read(&image))
+		{
+			entry.error = tr("Failed to load image from:\r\n%1\r\n%2").arg(url.toString(), reader.errorString());
+		}
+	}
+	else
+	{
+		QByteArray data = download(url, &entry.error, token);
+
+		if (entry.error.isEmpty() && token.isCanceled())
+		{
+			entry.error = tr("Canceled before loading:\r\n%1").arg(url.toString());
+		}
+		else if (entry.error.isEmpty())
+		{
+			QBuffer buffer(&data);
+			QImageReader reader(&buffer);
+
+			if (!reader.read(&image))
+			{
+				entry.error = tr("Failed to load image from:\r\n%1\r\n%2").arg(url.toString(), reader.errorString());
+			}
+		}
+	}
+
+	entry.loaded = true;
+
+	if (entry.error.isEmpty())
+	{
+		entry.sourceSize = image.size();
+		entry.levels = { image };
+		entry.modified = modifiedTime(url);
+		entry.thumbnail = ThumbnailStore::Thumbnail();
+
+		loaded(url, entry);
+
+		// Written in the background, the next session starts from it.
+		if (ThumbnailStore::cacheable(url) && !ThumbnailStore::instance()->contains(url))
+		{
+			QtConcurrent::run([url, image, format]() {
+				ThumbnailStore::instance()->insert(url, image, format);
+			});
+		}
+	}
+
+	return entry.error.isEmpty();
+}
+
+void ImageCache::loaded(const QUrl& url, const Entry& entry)
+{
+	{
+		QMutexLocker lock(&m_mutex);
+
+		m_sourceSizes[url] = entry.sourceSize;
+		m_thumbnailSizes.remove(url);
+		m_bytes[url] = levelBytes(entry.levels);
+	}
+
+	trim();
+}
+
+void ImageCache::trim()
+{
+	QMutexLocker lock(&m_mutex);
+
+	qint64 total = 0;
+
+	for (auto bytes : m_bytes)
+	{
+		total += bytes;
+	}
+
+	// The most recently used image always survives, however large it is.
+	while (total > m_budget && m_recent.count() > 1)
+	{
+		QUrl oldest = m_recent.takeFirst();
+
+		total -= m_bytes.take(oldest);
+
+		m_entries.remove(oldest);
+		m_sourceSizes.remove(oldest);
+		m_thumbnailSizes.remove(oldest);
+	}
+}
+
+// Runs on the image provider threads, which can host their own event loop.
+QByteArray ImageCache::download(const QUrl& url, QString* error, const CancellationToken& token)
+{
+	return RemoteFetcher::instance()->fetchAndWait(url, error, token);
+}
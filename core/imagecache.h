@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QHash>
+#include <QUrl>
+#include <QVector>
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+#include "thumbnailstore.h"
+
+// Decodes every url once and keeps a lazily built mip pyramid of it, so the QML views
+// (through MipImageProvider) and the exporter share the same decoded pixels. Requests a stored thumbnail
+// covers are served from the ThumbnailStore without decoding, which then waits for a larger request.
+class WAIFU2UGC_CORE_EXPORT ImageCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit ImageCache(QObject* parent = nullptr);
+
+	static ImageCache* instance();
+
+	static QString providerName();
+	static QUrl fromProviderId(const QString& id);
+
+	Q_INVOKABLE QUrl providerUrl(const QUrl& url) const;
+	Q_INVOKABLE QSize sourceSize(const QUrl& url) const;
+	Q_INVOKABLE QSize requestSize(qreal width, qreal height) const;
+
+	// Only decoded images, a url served from its thumbnail so far still has a source size but is not contained.
+	bool contains(const QUrl& url) const;
+	void insert(const QUrl& url, const QImage& image);
+	void remove(const QUrl& url);
+
+	// A canceled token stops before the decode and while waiting for a download, failing the request.
+	QImage image(const QUrl& url, QString* error = nullptr, const CancellationToken& token = CancellationToken());
+	QImage level(const QUrl& url, const QSize& requestedSize, QSize* sourceSize = nullptr, QString* error = nullptr,
+				 const CancellationToken& token = CancellationToken());
+
+private:
+	struct Entry
+	{
+		QMutex mutex;
+
+		bool loaded = false;
+		QString error;
+
+		QSize sourceSize;
+		QVector<QImage> levels;
+
+		QDateTime modified;
+
+		bool thumbnailChecked = false;
+		ThumbnailStore::Thumbnail thumbnail;
+	};
+
+	QSharedPointer<Entry> entry(const QUrl& url);
+	bool load(Entry& entry, const QUrl& url, const CancellationToken& token);
+	bool thumbnail(Entry& entry, const QUrl& url, const QSize& requestedSize);
+
+	void loaded(const QUrl& url, const Entry& entry);
+	void trim();
+
+	static QByteArray download(const QUrl& url, QString* error, const CancellationToken& token);
+
+private:
+	static constexpr qint64 m_budget = 512 * 1024 * 1024;
+	static constexpr int m_minimumLevelSize = 64;
+
+	mutable QMutex m_mutex;
+
+	QHash< QUrl, QSharedPointer<Entry> > m_entries;
+	QHash<QUrl, QSize> m_sourceSizes;
+	QHash<QUrl, QSize> m_thumbnailSizes; // source sizes of the urls only served from thumbnails
+	QHash<QUrl, qint64> m_bytes;
+	QList<QUrl> m_recent;
+};
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,332 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "pngbandencoder.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#include <zlib.h>
+
+// libpng's heuristic: the filter with the smallest sum of absolute (signed) residuals tends to deflate best.
+static void filterRow(const uchar* row, const uchar* previous, int length, int bytesPerPixel, QByteArray& output)
+{
+	static thread_local QByteArray candidates[5];
+
+	int best = 0;
+	quint64 bestSum = std::numeric_limits<quint64>::max();
+
+	int filters = previous != nullptr ? 5 : 2;
+
+	for (int filter = 0; filter < filters; ++filter)
+	{
+		QByteArray& candidate = candidates[filter];
+		candidate.resize(length);
+
+		uchar* target = reinterpret_cast<uchar*>(candidate.data());
+		quint64 sum = 0;
+
+		for (int i = 0; i < length; ++i)
+		{
+			int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+			int up = previous != nullptr ? previous[i] : 0;
+			int upLeft = previous != nullptr && i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+			int predicted = 0;
+
+			switch (filter)
+			{
+				case 1: predicted = left; break;
+				case 2: predicted = up; break;
+				case 3: predicted = (left + up) / 2; break;
+				case 4:
+				{
+					int estimate = left + up - upLeft;
+					int distanceLeft = std::abs(estimate - left);
+					int distanceUp = std::abs(estimate - up);
+					int distanceUpLeft = std::abs(estimate - upLeft);
+
+					predicted = distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft ? left : (distanceUp <= distanceUpLeft ? up : upLeft);
+					break;
+				}
+				default: break;
+			}
+
+			uchar value = uchar(row[i] - predicted);
+			target[i] = value;
+			sum += value < 128 ? value : 256 - value;
+		}
+
+		if (sum < bestSum)
+		{
+			best = filter;
+			bestSum = sum;
+		}
+	}
+
+	output.append(char(best));
+	output.append(candidates[best]);
+}
+
+static void appendChunk(QByteArray& png, const char* type, const QByteArray& data)
+{
+	uchar length[4];
+	qToBigEndian<quint32>(quint32(data.size()), length);
+
+	png.append(reinterpret_cast<const char*>(length), 4);
+
+	int start = png.size();
+	png.append(type, 4);
+	png.append(data);
+
+	uchar crc[4];
+	qToBigEndian<quint32>(quint32(crc32(0, reinterpret_cast<const Bytef*>(png.constData() + start), uInt(png.size() - start))), crc);
+
+	png.append(reinterpret_cast<const char*>(crc), 4);
+}
+
+PngBandEncoder::PngBandEncoder(const QImage& templateImage, const QVector<QRect>& faceRects, int bandHeight) :
+	m_size(templateImage.size()),
+	m_alpha(templateImage.hasAlphaChannel()),
+	m_bandHeight(std::max(1, bandHeight))
+{
+	if (templateImage.isNull())
+	{
+		return;
+	}
+
+	QImage pixels = convert(templateImage);
+
+	m_bands.resize((m_size.height() + m_bandHeight - 1) / m_bandHeight);
+
+	for (int band = 0; band < m_bands.count(); ++band)
+	{
+		int first = band * m_bandHeight;
+		int last = std::min(first + m_bandHeight, m_size.height());
+
+		m_bands[band].cached = std::none_of(faceRects.begin(), faceRects.end(), [first, last](const QRect& rect) {
+			return !rect.isEmpty() && rect.top() < last && rect.bottom() >= first;
+		});
+	}
+
+	for (int band = 0; band < m_bands.count(); ++band)
+	{
+		if (m_bands[band].cached)
+		{
+			int first = band * m_bandHeight;
+			QByteArray filtered = filter(pixels, first, std::min(first + m_bandHeight, m_size.height()));
+
+			m_bands[band] = compress(filtered, QByteArray());
+			m_bands[band].cached = true;
+
+			// Only a per tile band can be primed with what precedes it, see encode().
+			if (band + 1 < m_bands.count() && !m_bands[band + 1].cached)
+			{
+				m_bands[band].tail = filtered.right(m_windowSize);
+			}
+		}
+	}
+}
+
+void PngBandEncoder::setParallel(bool parallel)
+{
+	m_parallel = parallel;
+}
+
+bool PngBandEncoder::parallel() const
+{
+	return m_parallel;
+}
+
+bool PngBandEncoder::isNull() const
+{
+	return m_bands.isEmpty();
+}
+
+int PngBandEncoder::cachedBands() const
+{
+	return int(std::count_if(m_bands.begin(), m_bands.end(), [](const Band& band) { return band.cached; }));
+}
+
+QImage PngBandEncoder::convert(const QImage& image) const
+{
+	return image.convertToFormat(m_alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+}
+
+// Rows are filtered within the band only, the first one never looks at the band above.
+QByteArray PngBandEncoder::filter(const QImage& pixels, int first, int last) const
+{
+	int bytesPerPixel = m_alpha ? 4 : 3;
+	int length = m_size.width() * bytesPerPixel;
+
+	QByteArray filtered;
+	filtered.reserve((last - first) * (length + 1));
+
+	for (int y = first; y < last; ++y)
+	{
+		filterRow(pixels.constScanLine(y), y > first ? pixels.constScanLine(y - 1) : nullptr, length, bytesPerPixel, filtered);
+	}
+
+	return filtered;
+}
+
+// Every band is a raw deflate stream of its own ended by a full flush, so bands can be concatenated into one IDAT.
+// A band primed with the bytes preceding it in the tile (pigz does the same for its blocks) may refer back to them,
+// which the decoder has in its window anyway; a band without a dictionary fits after anything.
+PngBandEncoder::Band PngBandEncoder::compress(const QByteArray& filtered, const QByteArray& dictionary) const
+{
+	Band band;
+
+	band.length = filtered.size();
+	band.adler = quint32(adler32(1, reinterpret_cast<const Bytef*>(filtered.constData()), uInt(filtered.size())));
+
+	z_stream stream = {};
+
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		return Band();
+	}
+
+	if (!dictionary.isEmpty() &&
+		deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.constData()), uInt(dictionary.size())) != Z_OK)
+	{
+		deflateEnd(&stream);
+		return Band();
+	}
+
+	band.deflated.resize(int(deflateBound(&stream, uLong(filtered.size()))) + 16);
+
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(filtered.constData()));
+	stream.avail_in = uInt(filtered.size());
+	stream.next_out = reinterpret_cast<Bytef*>(band.deflated.data());
+	stream.avail_out = uInt(band.deflated.size());
+
+	int status = deflate(&stream, Z_FULL_FLUSH);
+
+	band.deflated.resize(int(stream.total_out));
+	deflateEnd(&stream);
+
+	if (status != Z_OK || stream.avail_in != 0 || stream.avail_out == 0)
+	{
+		return Band();
+	}
+
+	return band;
+}
+
+QByteArray PngBandEncoder::encode(const QImage& tile, const CancellationToken& token) const
+{
+	if (isNull() || tile.size() != m_size)
+	{
+		return QByteArray();
+	}
+
+	QImage pixels = convert(tile);
+
+	QVector<int> work;
+
+	for (int band = 0; band < m_bands.count(); ++band)
+	{
+		if (!m_bands[band].cached)
+		{
+			work.append(band);
+		}
+	}
+
+	// Filtering everything first gives each band its dictionary without waiting for the one before,
+	// so the two passes can run on every core. Either way the bytes are the same.
+	QVector<QByteArray> filtered(m_bands.count());
+	QVector<Band> compressed(m_bands.count());
+
+	auto filterBand = [&](int band) {
+		if (!token.isCanceled())
+		{
+			int first = band * m_bandHeight;
+			filtered[band] = filter(pixels, first, std::min(first + m_bandHeight, m_size.height()));
+		}
+	};
+
+	auto compressBand = [&](int band) {
+		if (!token.isCanceled())
+		{
+			const QByteArray& previous = band == 0 ? QByteArray() : (m_bands[band - 1].cached ? m_bands[band - 1].tail : filtered[band - 1]);
+			compressed[band] = compress(filtered[band], previous.right(m_windowSize));
+		}
+	};
+
+	if (m_parallel)
+	{
+		QtConcurrent::blockingMap(work, filterBand);
+		QtConcurrent::blockingMap(work, compressBand);
+	}
+	else
+	{
+		std::for_each(work.begin(), work.end(), filterBand);
+		std::for_each(work.begin(), work.end(), compressBand);
+	}
+
+	if (token.isCanceled())
+	{
+		return QByteArray();
+	}
+
+	QByteArray stream("\x78\x9c", 2);
+	quint32 adler = 1;
+
+	for (int band = 0; band < m_bands.count(); ++band)
+	{
+		const Band& part = m_bands[band].cached ? m_bands[band] : compressed[band];
+
+		if (part.length == 0)
+		{
+			return QByteArray();
+		}
+
+		stream.append(part.deflated);
+		adler = quint32(adler32_combine(adler, part.adler, part.length));
+	}
+
+	// An empty final block with fixed codes closes the stream.
+	stream.append("\x03\x00", 2);
+
+	uchar checksum[4];
+	qToBigEndian<quint32>(adler, checksum);
+	stream.append(reinterpret_cast<const char*>(checksum), 4);
+
+	QByteArray header(13, '\0');
+	qToBigEndian<quint32>(quint32(m_size.width()), header.data());
+	qToBigEndian<quint32>(quint32(m_size.height()), header.data() + 4);
+	header[8] = 8;
+	header[9] = m_alpha ? 6 : 2;
+
+	QByteArray png("\x89PNG\r\n\x1a\n", 8);
+	appendChunk(png, "IHDR", header);
+	appendChunk(png, "IDAT", stream);
+	appendChunk(png, "IEND", QByteArray());
+
+	return png;
+}
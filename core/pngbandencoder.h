@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef PNGBANDENCODER_H
+#define PNGBANDENCODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+
+// Writes the PNG tiles of one export in horizontal bands, each deflated on its own and ended by a full flush.
+// Bands crossing no face are only template pixels, so they are filtered and compressed once and spliced into
+// every tile; only the bands a face touches are compressed per tile.
+class WAIFU2UGC_CORE_EXPORT PngBandEncoder
+{
+public:
+	PngBandEncoder() = default;
+	PngBandEncoder(const QImage& templateImage, const QVector<QRect>& faceRects, int bandHeight = 16);
+
+	// Filters and deflates the bands of one tile on the thread pool, for exports of a few large tiles.
+	void setParallel(bool parallel);
+	bool parallel() const;
+
+	bool isNull() const;
+	int cachedBands() const;
+
+	// Empty when the token is canceled between two bands.
+	QByteArray encode(const QImage& tile, const CancellationToken& token = CancellationToken()) const;
+
+private:
+	struct Band
+	{
+		QByteArray deflated;
+		quint32 adler = 1;
+		qint64 length = 0;
+		bool cached = false;
+
+		QByteArray tail; // the last filtered bytes of a cached band, the dictionary of the band after it
+	};
+
+	QImage convert(const QImage& image) const;
+	QByteArray filter(const QImage& pixels, int first, int last) const;
+	Band compress(const QByteArray& filtered, const QByteArray& dictionary) const;
+
+private:
+	QSize m_size;
+	bool m_alpha = true;
+	int m_bandHeight = 16;
+	bool m_parallel = false;
+
+	QVector<Band> m_bands;
+
+	static constexpr int m_windowSize = 32 * 1024;
+};
+
+#endif // PNGBANDENCODER_H
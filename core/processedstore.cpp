@@ -0,0 +1,263 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "processedstore.h"
+#include "faceprocessor.h"
+#include "remotefetcher.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QMutexLocker>
+#include <QDebug>
+
+#include <cstring>
+
+Q_GLOBAL_STATIC(ProcessedStore, globalProcessedStore)
+
+namespace
+{
+	struct Header
+	{
+		char magic[4];
+		quint32 version;
+		qint32 width;
+		qint32 height;
+		qint32 bytesPerLine;
+		qint32 format;
+	};
+
+	constexpr char magic[4] = { 'W', '2', 'U', 'F' };
+	constexpr quint32 version = 3; // 3: QImage::scaled again, drops the faces version 2 resampled differently
+
+	// Scanlines start on a cache line so the mapped image is as aligned as a QImage allocation.
+	constexpr qint64 pixelOffset = 64;
+}
+
+static void unmap(void* info)
+{
+	delete static_cast<QFile*>(info);
+}
+
+// Only formats whose pixels are fully described by the scanlines, indexed ones would need their color table.
+static bool isStorable(QImage::Format format)
+{
+	return format > QImage::Format_Indexed8 && format < QImage::NImageFormats;
+}
+
+ProcessedStore::ProcessedStore() :
+	m_directory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("processed"))
+{
+	QDir().mkpath(m_directory);
+}
+
+ProcessedStore* ProcessedStore::instance()
+{
+	return globalProcessedStore();
+}
+
+QString ProcessedStore::directory() const
+{
+	return m_directory;
+}
+
+qint64 ProcessedStore::budget() const
+{
+	return m_budget;
+}
+
+void ProcessedStore::setBudget(qint64 budget)
+{
+	QMutexLocker lock(&m_mutex);
+
+	m_budget = budget;
+}
+
+// Local textures are identified by their path, size and modification time, which a save changes without reading
+// the whole file on every lookup. Files without a modification time, such as resources, are identified by their bytes.
+// Remote ones are identified by the bytes this process downloaded for them, fetching them first (revalidated through
+// the network cache) when it has none yet, so a texture changed on the server gets a new key.
+QString ProcessedStore::key(const FaceData& face, const CancellationToken& token) const
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	const QUrl& url = face.faceImageUrl();
+
+	if (!RemoteFetcher::isRemote(url))
+	{
+		QFileInfo info(url.isLocalFile() ? url.toLocalFile() : ":" + url.path());
+
+		if (!info.exists())
+		{
+			return QString();
+		}
+
+		QDateTime modified = info.lastModified();
+
+		if (modified.isValid() && modified.toMSecsSinceEpoch() > 0)
+		{
+			hash.addData(info.absoluteFilePath().toUtf8());
+			hash.addData(QByteArray::number(info.size()) + ':' + QByteArray::number(modified.toMSecsSinceEpoch()));
+		}
+		else
+		{
+			QFile file(info.filePath());
+
+			if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file))
+			{
+				return QString();
+			}
+		}
+	}
+	else
+	{
+		QByteArray content = RemoteFetcher::instance()->contentHash(url);
+
+		if (content.isEmpty())
+		{
+			QString error;
+			RemoteFetcher::instance()->fetchAndWait(url, &error, token);
+
+			content = RemoteFetcher::instance()->contentHash(url);
+		}
+
+		if (content.isEmpty())
+		{
+			return QString();
+		}
+
+		hash.addData(content);
+	}
+
+	hash.addData(FaceProcessor::key(face).toUtf8());
+
+	return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ProcessedStore::filePath(const QString& key) const
+{
+	return QDir(m_directory).filePath(key + ".face");
+}
+
+QImage ProcessedStore::find(const QString& key) const
+{
+	if (key.isEmpty())
+	{
+		return QImage();
+	}
+
+	auto file = new QFile(filePath(key));
+
+	if (!file->open(QIODevice::ReadOnly))
+	{
+		delete file;
+		return QImage();
+	}
+
+	Header header;
+
+	if (file->read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+			std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+			header.width <= 0 || header.height <= 0 || !isStorable(QImage::Format(header.format)) ||
+			header.bytesPerLine % 4 != 0 ||
+			header.bytesPerLine < (qint64(header.width) * QImage::toPixelFormat(QImage::Format(header.format)).bitsPerPixel() + 7) / 8 ||
+			file->size() != pixelOffset + qint64(header.bytesPerLine) * header.height)
+	{
+		delete file;
+		return QImage();
+	}
+
+	uchar* pixels = file->map(pixelOffset, qint64(header.bytesPerLine) * header.height);
+
+	if (pixels == nullptr)
+	{
+		delete file;
+		return QImage();
+	}
+
+	// Marks the entry as recently used for the eviction of every process.
+	file->setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+	// Read only: painting from the image never copies it, writing to it would detach first.
+	return QImage(const_cast<const uchar*>(pixels), header.width, header.height, header.bytesPerLine,
+				  QImage::Format(header.format), unmap, file);
+}
+
+void ProcessedStore::insert(const QString& key, const QImage& image)
+{
+	if (key.isEmpty() || image.isNull() || !isStorable(image.format()))
+	{
+		return;
+	}
+
+	Header header;
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.width = image.width();
+	header.height = image.height();
+	header.bytesPerLine = image.bytesPerLine();
+	header.format = image.format();
+
+	// Written under a temporary name and renamed, so other processes never map a partial file.
+	QSaveFile file(filePath(key));
+
+	if (!file.open(QIODevice::WriteOnly) ||
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+			file.write(QByteArray(int(pixelOffset - sizeof(header)), '\0')) < 0 ||
+			file.write(reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes()) != image.sizeInBytes() ||
+			!file.commit())
+	{
+		qWarning() << "Failed to store processed face" << key << file.errorString();
+		return;
+	}
+
+	trim();
+}
+
+// Least recently used first, by the modification times find() refreshes.
+void ProcessedStore::trim()
+{
+	QMutexLocker lock(&m_mutex);
+
+	QFileInfoList entries = QDir(m_directory).entryInfoList({ "*.face" }, QDir::Files, QDir::Time);
+	qint64 total = 0;
+
+	for (const QFileInfo& entry : entries)
+	{
+		total += entry.size();
+	}
+
+	while (total > m_budget && entries.count() > 1)
+	{
+		QFileInfo oldest = entries.takeLast();
+
+		if (QFile::remove(oldest.filePath()))
+		{
+			total -= oldest.size();
+		}
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef PROCESSEDSTORE_H
+#define PROCESSEDSTORE_H
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+#include "facedata.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+// Processed faces on disk, shared by every process of the machine: the application, shards and render services.
+// Files hold the raw scanlines after a small header, so a hit maps the file and composites from it without copying.
+class WAIFU2UGC_CORE_EXPORT ProcessedStore
+{
+public:
+	ProcessedStore();
+
+	static ProcessedStore* instance();
+
+	QString directory() const;
+
+	qint64 budget() const;
+	void setBudget(qint64 budget);
+
+	// Empty when the texture cannot be identified, such a face is not stored.
+	QString key(const FaceData& face, const CancellationToken& token = CancellationToken()) const;
+
+	QImage find(const QString& key) const;
+	void insert(const QString& key, const QImage& image);
+
+private:
+	QString filePath(const QString& key) const;
+	void trim();
+
+	QString m_directory;
+	qint64 m_budget = qint64(1024) * 1024 * 1024;
+
+	mutable QMutex m_mutex;
+};
+
+#endif // PROCESSEDSTORE_H
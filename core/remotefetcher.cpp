@@ -0,0 +1,224 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "remotefetcher.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QEventLoop>
+#include <QImageReader>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+#include <QNetworkReply>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+
+Q_GLOBAL_STATIC(RemoteFetcher, globalRemoteFetcher)
+
+RemoteFetcher::RemoteFetcher(QObject* parent) : QObject(parent)
+{
+	// The first caller may be an image provider thread, the network has to live on the main one.
+	if (parent == nullptr && QCoreApplication::instance() != nullptr)
+	{
+		moveToThread(QCoreApplication::instance()->thread());
+	}
+}
+
+RemoteFetcher* RemoteFetcher::instance()
+{
+	return globalRemoteFetcher();
+}
+
+bool RemoteFetcher::isRemote(const QUrl& url)
+{
+	return !url.isLocalFile() && url.scheme() != "qrc";
+}
+
+int RemoteFetcher::maxConnections() const
+{
+	return m_maxConnections;
+}
+
+void RemoteFetcher::setMaxConnections(int maxConnections)
+{
+	m_maxConnections = std::max(1, maxConnections);
+}
+
+// Safe from any thread; every caller waiting for the same url is answered by one download.
+void RemoteFetcher::fetch(const QUrl& url)
+{
+	QMetaObject::invokeMethod(this, [this, url]() {
+		if (!m_pending.contains(url))
+		{
+			m_pending.insert(url);
+			m_queue.enqueue(url);
+
+			startNext();
+		}
+	}, Qt::QueuedConnection);
+}
+
+void RemoteFetcher::abort(const QUrl& url)
+{
+	QMetaObject::invokeMethod(this, [this, url]() {
+		if (QNetworkReply* reply = m_replies.value(url))
+		{
+			// Answered by replyFinished() with the cancellation error.
+			reply->abort();
+		}
+		else if (m_queue.removeAll(url) > 0)
+		{
+			m_pending.remove(url);
+
+			emit fetched(url, QByteArray(), tr("Canceled before downloading:\r\n%1").arg(url.toString()));
+		}
+	}, Qt::QueuedConnection);
+}
+
+QByteArray RemoteFetcher::fetchAndWait(const QUrl& url, QString* error, const CancellationToken& token)
+{
+	QEventLoop loop;
+	QByteArray data;
+	QString message;
+
+	connect(this, &RemoteFetcher::fetched, &loop, [&](const QUrl& fetchedUrl, const QByteArray& fetchedData, const QString& fetchedError) {
+		if (fetchedUrl == url)
+		{
+			data = fetchedData;
+			message = fetchedError;
+			loop.quit();
+		}
+	});
+
+	QTimer poll;
+	connect(&poll, &QTimer::timeout, &loop, [&]() {
+		if (token.isCanceled())
+		{
+			message = tr("Canceled while downloading:\r\n%1").arg(url.toString());
+			loop.quit();
+		}
+	});
+	poll.start(m_cancelPollInterval);
+
+	fetch(url);
+	loop.exec();
+
+	if (error != nullptr)
+	{
+		*error = message;
+	}
+
+	return data;
+}
+
+QByteArray RemoteFetcher::contentHash(const QUrl& url) const
+{
+	QMutexLocker lock(&m_hashMutex);
+
+	return m_contentHashes.value(url);
+}
+
+void RemoteFetcher::startNext()
+{
+	while (m_active < m_maxConnections && !m_queue.isEmpty())
+	{
+		QNetworkRequest request(m_queue.dequeue());
+		request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+		request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferNetwork);
+		request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, true);
+
+		QNetworkReply* reply = manager()->get(request);
+		m_replies[request.url()] = reply;
+
+		connect(reply, &QNetworkReply::downloadProgress, reply, [reply](qint64 received, qint64 total) {
+			if (std::max(received, total) > m_maxImageSize)
+			{
+				reply->abort();
+			}
+		});
+		connect(reply, &QNetworkReply::finished, this, [this, reply]() { replyFinished(reply); });
+
+		++m_active;
+	}
+}
+
+void RemoteFetcher::replyFinished(QNetworkReply* reply)
+{
+	--m_active;
+	reply->deleteLater();
+
+	QUrl url = reply->request().url();
+	m_replies.remove(url);
+
+	QByteArray data;
+	QString error;
+
+	if (reply->error() != QNetworkReply::NoError)
+	{
+		error = tr("Error downloading image from:\r\n%1\r\n%2").arg(url.toString(), reply->errorString());
+	}
+	else
+	{
+		data = reply->readAll();
+
+		QBuffer buffer(&data);
+		QImageReader reader(&buffer);
+
+		// Only the header is checked here, decoding is left to whoever asked for it.
+		if (!reader.canRead() || !reader.size().isValid())
+		{
+			error = tr("The file downloaded from:\r\n%1\r\nis not a supported image.").arg(url.toString());
+			data.clear();
+		}
+		else
+		{
+			QMutexLocker lock(&m_hashMutex);
+			m_contentHashes[url] = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+		}
+	}
+
+	m_pending.remove(url);
+
+	emit fetched(url, data, error);
+
+	startNext();
+}
+
+QNetworkAccessManager* RemoteFetcher::manager()
+{
+	if (m_manager == nullptr)
+	{
+		auto cache = new QNetworkDiskCache(this);
+		cache->setCacheDirectory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("remote"));
+		cache->setMaximumCacheSize(m_cacheSize);
+
+		m_manager = new QNetworkAccessManager(this);
+		m_manager->setCache(cache);
+	}
+
+	return m_manager;
+}
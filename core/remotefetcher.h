@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef REMOTEFETCHER_H
+#define REMOTEFETCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QSet>
+#include <QUrl>
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Downloads remote images a few at a time through a persistent disk cache. Cached copies are
+// revalidated with their ETag/Last-Modified, so exporting the same design again stays local.
+class WAIFU2UGC_CORE_EXPORT RemoteFetcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit RemoteFetcher(QObject* parent = nullptr);
+
+	static RemoteFetcher* instance();
+	static bool isRemote(const QUrl& url);
+
+	int maxConnections() const;
+	void setMaxConnections(int maxConnections);
+
+	void fetch(const QUrl& url);
+
+	// Drops a queued url or aborts its download; whoever waits for it gets an error.
+	void abort(const QUrl& url);
+
+	// Stops waiting as soon as the token is canceled; the download itself finishes in the background.
+	QByteArray fetchAndWait(const QUrl& url, QString* error, const CancellationToken& token = CancellationToken());
+
+	// SHA-1 of the bytes last fetched for the url, empty until this process fetched it. Safe from any thread.
+	QByteArray contentHash(const QUrl& url) const;
+
+signals:
+	void fetched(const QUrl& url, const QByteArray& data, const QString& error);
+
+private:
+	void startNext();
+	void replyFinished(QNetworkReply* reply);
+
+	QNetworkAccessManager* manager();
+
+private:
+	QNetworkAccessManager* m_manager = nullptr;
+
+	QQueue<QUrl> m_queue;
+	QSet<QUrl> m_pending;
+	QHash<QUrl, QNetworkReply*> m_replies;
+
+	mutable QMutex m_hashMutex;
+	QHash<QUrl, QByteArray> m_contentHashes;
+
+	int m_active = 0;
+	int m_maxConnections = 4;
+
+	static constexpr qint64 m_cacheSize = 256 * 1024 * 1024;
+	static constexpr qint64 m_maxImageSize = 64 * 1024 * 1024;
+	static constexpr int m_cancelPollInterval = 10; // milliseconds
+};
+
+#endif // REMOTEFETCHER_H
@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef SHARDSPEC_H
+#define SHARDSPEC_H
+
+#include <QString>
+#include <QStringList>
+
+// Shard i of N renders every tile whose position in the export order is i modulo N,
+// which keeps the split deterministic and the shards evenly loaded.
+class ShardSpec
+{
+public:
+	int& index()				{ return m_index; }
+	int index() const			{ return m_index; }
+
+	int& count()				{ return m_count; }
+	int count() const			{ return m_count; }
+
+	bool isSharded() const		{ return m_count > 1; }
+	bool contains(int tile) const	{ return tile % m_count == m_index; }
+
+	QString toString() const	{ return QString("%1/%2").arg(m_index).arg(m_count); }
+
+	static bool parse(const QString& text, ShardSpec& shard)
+	{
+		QStringList parts = text.split('/');
+
+		if (parts.count() != 2)
+		{
+			return false;
+		}
+
+		bool indexOk = false;
+		bool countOk = false;
+
+		shard.m_index = parts[0].toInt(&indexOk);
+		shard.m_count = parts[1].toInt(&countOk);
+
+		return indexOk && countOk && shard.m_count >= 1 && shard.m_index >= 0 && shard.m_index < shard.m_count;
+	}
+
+private:
+	int m_index = 0;
+	int m_count = 1;
+};
+
+#endif // SHARDSPEC_H
@@ -0,0 +1,228 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "stagetuner.h"
+
+#include <QSettings>
+#include <QThread>
+
+#include <algorithm>
+
+StageTuner::Limits StageTuner::Limits::load()
+{
+	Limits limits;
+	limits.maxEncoders = QThread::idealThreadCount();
+
+	QSettings settings;
+	settings.beginGroup("tuning");
+
+	limits.minEncoders = std::max(1, settings.value("minEncoders", limits.minEncoders).toInt());
+	limits.maxEncoders = std::max(limits.minEncoders, settings.value("maxEncoders", limits.maxEncoders).toInt());
+	limits.minWriters = std::max(1, settings.value("minWriters", limits.minWriters).toInt());
+	limits.maxWriters = std::max(limits.minWriters, settings.value("maxWriters", limits.maxWriters).toInt());
+
+	limits.pinnedEncoders = std::max(0, settings.value("encoders", 0).toInt());
+	limits.pinnedWriters = std::max(0, settings.value("writers", 0).toInt());
+
+	return limits;
+}
+
+StageTuner::StageTuner(const Limits& limits, int encoders, int tiles) : m_limits(limits)
+{
+	m_encoders = qBound(limits.minEncoders, limits.pinnedEncoders > 0 ? limits.pinnedEncoders : encoders, limits.maxEncoders);
+	m_writers = qBound(limits.minWriters, limits.pinnedWriters > 0 ? limits.pinnedWriters : m_initialWriters, limits.maxWriters);
+
+	// Windows span a few pipelines worth of tiles, the tiles still in flight after a change then weigh little.
+	m_window = std::max(m_minimumWindow, 3 * inFlight());
+	m_budget = tiles / 3;
+
+	m_phase = limits.pinnedEncoders > 0 ? WRITERS : ENCODERS;
+	m_phaseStart = m_bestValue = value();
+
+	if (m_phase == WRITERS && limits.pinnedWriters > 0)
+	{
+		m_phase = SETTLED;
+	}
+
+	// The first window only fills the pipeline, two more are needed to compare anything.
+	if (m_budget < 3 * m_window)
+	{
+		m_phase = SETTLED;
+	}
+
+	m_clock.start();
+}
+
+int StageTuner::encoders() const
+{
+	QMutexLocker lock(&m_mutex);
+	return m_encoders;
+}
+
+int StageTuner::writers() const
+{
+	QMutexLocker lock(&m_mutex);
+	return m_writers;
+}
+
+// Enough tiles for every thread to be busy and the composer to be one tile ahead.
+int StageTuner::inFlight() const
+{
+	QMutexLocker lock(&m_mutex);
+	return m_encoders + m_writers + 1;
+}
+
+void StageTuner::record(Stage stage, qint64 nanoseconds)
+{
+	QMutexLocker lock(&m_mutex);
+
+	m_stageTime[stage] += nanoseconds;
+	++m_stageCount[stage];
+}
+
+void StageTuner::tileDone()
+{
+	QMutexLocker lock(&m_mutex);
+
+	++m_done;
+
+	if (m_phase == SETTLED || ++m_windowDone < m_window)
+	{
+		return;
+	}
+
+	qint64 now = m_clock.nsecsElapsed();
+	double throughput = m_windowDone * 1e9 / std::max<qint64>(1, now - m_windowStart);
+
+	m_windowDone = 0;
+	m_windowStart = now;
+
+	if (m_windows++ > 0)
+	{
+		evaluate(throughput);
+	}
+
+	if (m_phase != SETTLED && m_done >= m_budget)
+	{
+		value() = m_bestValue;
+		m_phase = SETTLED;
+	}
+}
+
+void StageTuner::evaluate(double throughput)
+{
+	if (m_best > 0.0 && throughput <= m_best * (1.0 + m_minimumGain))
+	{
+		// The last move did not pay off: back to the best value, then the other direction if nothing was gained yet.
+		value() = m_bestValue;
+
+		if (m_direction > 0 && m_bestValue == m_phaseStart)
+		{
+			m_direction = -1;
+
+			if (advance())
+			{
+				return;
+			}
+		}
+
+		nextPhase();
+		return;
+	}
+
+	m_best = throughput;
+	m_bestValue = value();
+
+	if (!advance())
+	{
+		nextPhase();
+	}
+}
+
+bool StageTuner::advance()
+{
+	int next = m_bestValue + m_direction * step();
+
+	bool encoders = m_phase == ENCODERS;
+	int minimum = encoders ? m_limits.minEncoders : m_limits.minWriters;
+	int maximum = encoders ? m_limits.maxEncoders : m_limits.maxWriters;
+
+	if (next < minimum || next > maximum)
+	{
+		return false;
+	}
+
+	value() = next;
+	return true;
+}
+
+void StageTuner::nextPhase()
+{
+	if (m_phase == ENCODERS && m_limits.pinnedWriters == 0)
+	{
+		m_phase = WRITERS;
+		m_direction = 1;
+		m_phaseStart = m_bestValue = m_writers;
+
+		if (advance())
+		{
+			return;
+		}
+
+		m_direction = -1;
+
+		if (advance())
+		{
+			return;
+		}
+	}
+
+	m_phase = SETTLED;
+}
+
+int& StageTuner::value()
+{
+	return m_phase == WRITERS ? m_writers : m_encoders;
+}
+
+int StageTuner::step() const
+{
+	return m_phase == ENCODERS ? std::max(1, m_bestValue / 4) : 1;
+}
+
+QString StageTuner::text() const
+{
+	QMutexLocker lock(&m_mutex);
+
+	auto average = [this](Stage stage) {
+		return m_stageCount[stage] > 0 ? m_stageTime[stage] / 1e6 / m_stageCount[stage] : 0.0;
+	};
+
+	return tr("%1 encoders, %2 writers; per tile %3 ms composing, %4 ms encoding, %5 ms writing.")
+			.arg(m_encoders)
+			.arg(m_writers)
+			.arg(average(COMPOSE), 0, 'f', 1)
+			.arg(average(ENCODE), 0, 'f', 1)
+			.arg(average(WRITE), 0, 'f', 1);
+}
@@ -0,0 +1,120 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef STAGETUNER_H
+#define STAGETUNER_H
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include "waifu2ugccore.h"
+
+// Picks the number of encoding and writing threads of one export while it runs. The first part of the export is
+// measured in windows of tiles; after each window the tuner keeps a change that raised the tiles per second and
+// undoes one that did not, first for the encoders and then for the writers, and settles on the best configuration.
+// Limits and pinned values come from the "tuning" settings group, e.g. encoders=6 and writers=2 as logged by text().
+class WAIFU2UGC_CORE_EXPORT StageTuner
+{
+	Q_DECLARE_TR_FUNCTIONS(StageTuner)
+
+public:
+	enum Stage {
+		COMPOSE,
+		ENCODE,
+		WRITE
+	};
+
+	struct Limits
+	{
+		int minEncoders = 1;
+		int maxEncoders = 1;
+		int minWriters = 1;
+		int maxWriters = 8;
+
+		// Non zero values fix the stage and skip its tuning.
+		int pinnedEncoders = 0;
+		int pinnedWriters = 0;
+
+		static Limits load();
+	};
+
+	StageTuner(const Limits& limits, int encoders, int tiles);
+
+	int encoders() const;
+	int writers() const;
+	int inFlight() const;
+
+	// Both callable from any thread.
+	void record(Stage stage, qint64 nanoseconds);
+	void tileDone();
+
+	QString text() const;
+
+private:
+	enum Phase {
+		ENCODERS,
+		WRITERS,
+		SETTLED
+	};
+
+	void evaluate(double throughput);
+	bool advance();
+	void nextPhase();
+
+	int& value();
+	int step() const;
+
+private:
+	mutable QMutex m_mutex;
+
+	Limits m_limits;
+
+	int m_encoders = 1;
+	int m_writers = 2;
+
+	Phase m_phase = ENCODERS;
+	int m_direction = 1;
+	int m_phaseStart = 0;
+	int m_bestValue = 0;
+	double m_best = 0.0;
+
+	int m_window = 8;
+	int m_budget = 0;
+	int m_done = 0;
+	int m_windowDone = 0;
+	int m_windows = 0;
+	qint64 m_windowStart = 0;
+
+	qint64 m_stageTime[3] = {};
+	int m_stageCount[3] = {};
+
+	QElapsedTimer m_clock;
+
+	static constexpr int m_initialWriters = 2;
+	static constexpr int m_minimumWindow = 8;
+	static constexpr double m_minimumGain = 0.05;
+};
+
+#endif // STAGETUNER_H
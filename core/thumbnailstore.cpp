@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "thumbnailstore.h"
+#include "remotefetcher.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+Q_GLOBAL_STATIC(ThumbnailStore, globalThumbnailStore)
+
+static QFileInfo sourceInfo(const QUrl& url)
+{
+	return QFileInfo(url.isLocalFile() ? url.toLocalFile() : ":" + url.path());
+}
+
+// Size and modification time together, a copy over the file with the same time still changes its size.
+static QString stamp(const QUrl& url)
+{
+	QFileInfo info = sourceInfo(url);
+
+	return QString("%1/%2").arg(info.size()).arg(info.lastModified().isValid() ? info.lastModified().toMSecsSinceEpoch() : 0);
+}
+
+ThumbnailStore::ThumbnailStore() :
+	m_directory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("thumbnails"))
+{
+	QDir().mkpath(m_directory);
+}
+
+ThumbnailStore* ThumbnailStore::instance()
+{
+	return globalThumbnailStore();
+}
+
+QString ThumbnailStore::directory() const
+{
+	return m_directory;
+}
+
+// Remote images have no modification time to check the entry against, the network cache covers them.
+bool ThumbnailStore::cacheable(const QUrl& url)
+{
+	return !url.isEmpty() && !RemoteFetcher::isRemote(url) && sourceInfo(url).exists();
+}
+
+QString ThumbnailStore::filePath(const QUrl& url) const
+{
+	QByteArray hash = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1);
+
+	return QDir(m_directory).filePath(QString::fromLatin1(hash.toHex()) + ".png");
+}
+
+bool ThumbnailStore::contains(const QUrl& url) const
+{
+	if (!cacheable(url))
+	{
+		return false;
+	}
+
+	QImageReader reader(filePath(url), "png");
+
+	return reader.text("Url") == url.toString() && reader.text("Stamp") == stamp(url);
+}
+
+ThumbnailStore::Thumbnail ThumbnailStore::find(const QUrl& url) const
+{
+	Thumbnail thumbnail;
+
+	if (!cacheable(url))
+	{
+		return thumbnail;
+	}
+
+	QString path = filePath(url);
+	QImageReader reader(path, "png");
+
+	if (reader.text("Url") != url.toString() || reader.text("Stamp") != stamp(url))
+	{
+		return thumbnail;
+	}
+
+	QImage image;
+
+	if (!reader.read(&image))
+	{
+		return thumbnail;
+	}
+
+	thumbnail.image = image;
+	thumbnail.sourceSize = QSize(reader.text("Width").toInt(), reader.text("Height").toInt());
+	thumbnail.format = reader.text("Format").toLatin1();
+	thumbnail.modified = sourceInfo(url).lastModified();
+
+	if (thumbnail.sourceSize.isEmpty())
+	{
+		return Thumbnail();
+	}
+
+	// Marks the entry as recently used for trim().
+	QFile file(path);
+
+	if (file.open(QIODevice::ReadWrite))
+	{
+		file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+	}
+
+	return thumbnail;
+}
+
+void ThumbnailStore::insert(const QUrl& url, const QImage& image, const QByteArray& format)
+{
+	if (image.isNull() || !cacheable(url))
+	{
+		return;
+	}
+
+	QImage thumbnail = image.width() > m_size || image.height() > m_size ?
+				image.scaled(m_size, m_size, Qt::KeepAspectRatio, Qt::SmoothTransformation) : image;
+
+	thumbnail.setText("Url", url.toString());
+	thumbnail.setText("Stamp", stamp(url));
+	thumbnail.setText("Width", QString::number(image.width()));
+	thumbnail.setText("Height", QString::number(image.height()));
+	thumbnail.setText("Format", QString::fromLatin1(format));
+
+	QSaveFile file(filePath(url));
+	QImageWriter writer(&file, "png");
+
+	if (!file.open(QIODevice::WriteOnly) || !writer.write(thumbnail) || !file.commit())
+	{
+		qWarning() << "Failed to store thumbnail of" << url << writer.errorString();
+		return;
+	}
+
+	trim();
+}
+
+// Least recently used first, by the modification times find() refreshes.
+void ThumbnailStore::trim()
+{
+	QMutexLocker lock(&m_mutex);
+
+	QFileInfoList entries = QDir(m_directory).entryInfoList({ "*.png" }, QDir::Files, QDir::Time);
+	qint64 total = 0;
+
+	for (const QFileInfo& entry : entries)
+	{
+		total += entry.size();
+	}
+
+	while (total > m_budget && entries.count() > 1)
+	{
+		QFileInfo oldest = entries.takeLast();
+
+		if (QFile::remove(oldest.filePath()))
+		{
+			total -= oldest.size();
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include "waifu2ugccore.h"
+
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+
+// Small previews of the local images the application opened, kept on disk between sessions so the views can show
+// a restored session before anything is decoded. Each entry is a PNG carrying the size, format and modification time
+// of its source in text chunks; an entry whose source changed since is ignored.
+class WAIFU2UGC_CORE_EXPORT ThumbnailStore
+{
+public:
+	struct Thumbnail
+	{
+		QImage image;
+		QSize sourceSize;
+		QByteArray format;
+		QDateTime modified;
+
+		bool isNull() const { return image.isNull(); }
+	};
+
+	ThumbnailStore();
+
+	static ThumbnailStore* instance();
+
+	QString directory() const;
+
+	static bool cacheable(const QUrl& url);
+
+	bool contains(const QUrl& url) const;
+	Thumbnail find(const QUrl& url) const;
+	void insert(const QUrl& url, const QImage& image, const QByteArray& format);
+
+private:
+	QString filePath(const QUrl& url) const;
+	void trim();
+
+	QString m_directory;
+
+	mutable QMutex m_mutex;
+
+	static constexpr int m_size = 256; // enough for the face thumbnails, larger views decode the source
+	static constexpr qint64 m_budget = 64 * 1024 * 1024;
+};
+
+#endif // THUMBNAILSTORE_H
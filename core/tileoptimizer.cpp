@@ -0,0 +1,431 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "tileoptimizer.h"
+#include "pngbandencoder.h"
+
+#include <QBuffer>
+#include <QHash>
+#include <QImageWriter>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// The smallest of the lossless (or, if allowed, good enough lossy) encodings wins;
+// the tile saved as it is is kept as the baseline used for the savings report.
+TileOptimizer::Result TileOptimizer::encode(const QImage& tile, const Options& options, const PngBandEncoder* bands,
+											 const CancellationToken& token)
+{
+	Result result;
+
+	QByteArray baseline = bands != nullptr ? bands->encode(tile, token) : QByteArray();
+
+	if (token.isCanceled())
+	{
+		return Result();
+	}
+
+	if (baseline.isEmpty())
+	{
+		baseline = encodePng(tile);
+	}
+
+	result.baselineBytes = baseline.size();
+
+	if (!options.optimize)
+	{
+		result.data = baseline;
+		return result;
+	}
+
+	QImage image = tile.convertToFormat(QImage::Format_ARGB32);
+	bool opaque = isOpaque(image);
+
+	Kind kind = PALETTE;
+	QImage candidate = toExactPalette(image);
+
+	if (candidate.isNull() && opaque && options.quantize)
+	{
+		candidate = toQuantizedPalette(image);
+	}
+
+	if (candidate.isNull() && opaque)
+	{
+		kind = RGB;
+		candidate = image.convertToFormat(QImage::Format_RGB32);
+	}
+
+	result.data = stripAncillaryChunks(baseline);
+
+	if (token.isCanceled())
+	{
+		return Result();
+	}
+
+	if (!candidate.isNull())
+	{
+		QByteArray optimized = stripAncillaryChunks(encodePng(candidate));
+
+		if (!optimized.isEmpty() && optimized.size() < result.data.size())
+		{
+			result.data = optimized;
+			result.kind = kind;
+		}
+	}
+
+	return result;
+}
+
+QByteArray TileOptimizer::encodePng(const QImage& image)
+{
+	QByteArray data;
+	QBuffer buffer(&data);
+
+	buffer.open(QIODevice::WriteOnly);
+
+	QImageWriter writer(&buffer, "png");
+
+	if (!writer.write(image))
+	{
+		return QByteArray();
+	}
+
+	return data;
+}
+
+// Keeps the critical chunks and tRNS, which palette images need for their transparency.
+QByteArray TileOptimizer::stripAncillaryChunks(const QByteArray& png)
+{
+	static const QByteArray signature("\x89PNG\r\n\x1a\n", 8);
+
+	if (!png.startsWith(signature))
+	{
+		return png;
+	}
+
+	QByteArray stripped;
+	stripped.reserve(png.size());
+	stripped.append(signature);
+
+	qint64 position = signature.size();
+
+	while (position + 12 <= png.size())
+	{
+		qint64 length = qFromBigEndian<quint32>(png.constData() + position);
+		qint64 chunkSize = 12 + length;
+
+		if (position + chunkSize > png.size())
+		{
+			return png;
+		}
+
+		const char* type = png.constData() + position + 4;
+		bool critical = (type[0] & 0x20) == 0;
+
+		if (critical || qstrncmp(type, "tRNS", 4) == 0)
+		{
+			stripped.append(png.constData() + position, int(chunkSize));
+		}
+
+		position += chunkSize;
+	}
+
+	return stripped;
+}
+
+bool TileOptimizer::isOpaque(const QImage& image)
+{
+	for (int y = 0; y < image.height(); ++y)
+	{
+		const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+		for (int x = 0; x < image.width(); ++x)
+		{
+			if (qAlpha(line[x]) != 255)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+QImage TileOptimizer::toExactPalette(const QImage& image)
+{
+	QImage indexed(image.size(), QImage::Format_Indexed8);
+
+	QVector<QRgb> colors;
+	QHash<QRgb, uchar> lookup;
+	lookup.reserve(512);
+
+	for (int y = 0; y < image.height(); ++y)
+	{
+		const QRgb* source = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+		uchar* target = indexed.scanLine(y);
+
+		// Template pixels come in long runs, so most of them skip the hash lookup.
+		QRgb previous = 0;
+		uchar previousIndex = 0;
+		bool hasPrevious = false;
+
+		for (int x = 0; x < image.width(); ++x)
+		{
+			QRgb pixel = source[x];
+
+			if (!hasPrevious || pixel != previous)
+			{
+				auto it = lookup.constFind(pixel);
+
+				if (it == lookup.constEnd())
+				{
+					if (colors.count() == 256)
+					{
+						return QImage();
+					}
+
+					it = lookup.insert(pixel, uchar(colors.count()));
+					colors.append(pixel);
+				}
+
+				previous = pixel;
+				previousIndex = it.value();
+				hasPrevious = true;
+			}
+
+			target[x] = previousIndex;
+		}
+	}
+
+	indexed.setColorTable(colors);
+
+	return indexed;
+}
+
+// Median cut over a histogram of 5 bits per channel: the box holding the most pixels over the widest range is split at
+// its median until there are 256, each entry being the mean of the pixels in its box. Opaque images only.
+QImage TileOptimizer::toQuantizedPalette(const QImage& image)
+{
+	struct Bin
+	{
+		int count = 0;
+		qint64 red = 0;
+		qint64 green = 0;
+		qint64 blue = 0;
+	};
+
+	struct Box
+	{
+		QVector<int> bins;
+		qint64 population = 0;
+		int channel = 0;
+		int range = 0;
+	};
+
+	auto binOf = [](QRgb pixel) {
+		return ((qRed(pixel) >> 3) << 10) | ((qGreen(pixel) >> 3) << 5) | (qBlue(pixel) >> 3);
+	};
+
+	auto channelOf = [](int bin, int channel) {
+		return (bin >> (10 - 5 * channel)) & 31;
+	};
+
+	QVector<Bin> histogram(1 << 15);
+
+	for (int y = 0; y < image.height(); ++y)
+	{
+		const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+		for (int x = 0; x < image.width(); ++x)
+		{
+			Bin& bin = histogram[binOf(line[x])];
+
+			++bin.count;
+			bin.red += qRed(line[x]);
+			bin.green += qGreen(line[x]);
+			bin.blue += qBlue(line[x]);
+		}
+	}
+
+	auto measure = [&](Box& box) {
+		int minimum[3] = { 31, 31, 31 };
+		int maximum[3] = { 0, 0, 0 };
+
+		box.population = 0;
+
+		for (int bin : box.bins)
+		{
+			box.population += histogram[bin].count;
+
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				minimum[channel] = std::min(minimum[channel], channelOf(bin, channel));
+				maximum[channel] = std::max(maximum[channel], channelOf(bin, channel));
+			}
+		}
+
+		box.channel = 0;
+		box.range = 0;
+
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			if (maximum[channel] - minimum[channel] > box.range)
+			{
+				box.channel = channel;
+				box.range = maximum[channel] - minimum[channel];
+			}
+		}
+	};
+
+	QVector<Box> boxes(1);
+
+	for (int bin = 0; bin < histogram.count(); ++bin)
+	{
+		if (histogram[bin].count > 0)
+		{
+			boxes[0].bins.append(bin);
+		}
+	}
+
+	measure(boxes[0]);
+
+	while (boxes.count() < 256)
+	{
+		int widest = -1;
+
+		for (int i = 0; i < boxes.count(); ++i)
+		{
+			if (boxes[i].range > 0 && (widest < 0 || boxes[i].population * boxes[i].range > boxes[widest].population * boxes[widest].range))
+			{
+				widest = i;
+			}
+		}
+
+		if (widest < 0)
+		{
+			break;
+		}
+
+		Box& box = boxes[widest];
+		int channel = box.channel;
+
+		std::sort(box.bins.begin(), box.bins.end(), [&](int a, int b) {
+			return channelOf(a, channel) < channelOf(b, channel);
+		});
+
+		// The first bin past half the pixels starts the second box, both keep at least one bin.
+		qint64 half = box.population / 2;
+		qint64 seen = 0;
+		int split = 1;
+
+		while (split < box.bins.count() - 1 && seen + histogram[box.bins[split - 1]].count < half)
+		{
+			seen += histogram[box.bins[split - 1]].count;
+			++split;
+		}
+
+		Box second;
+		second.bins = box.bins.mid(split);
+		box.bins.resize(split);
+
+		measure(box);
+		measure(second);
+
+		boxes.append(second);
+	}
+
+	QVector<QRgb> colors;
+	QVector<uchar> lookup(histogram.count());
+
+	for (int i = 0; i < boxes.count(); ++i)
+	{
+		qint64 red = 0;
+		qint64 green = 0;
+		qint64 blue = 0;
+
+		for (int bin : boxes[i].bins)
+		{
+			red += histogram[bin].red;
+			green += histogram[bin].green;
+			blue += histogram[bin].blue;
+			lookup[bin] = uchar(i);
+		}
+
+		qint64 population = std::max<qint64>(1, boxes[i].population);
+		colors.append(qRgb(int((red + population / 2) / population), int((green + population / 2) / population),
+						   int((blue + population / 2) / population)));
+	}
+
+	QImage quantized(image.size(), QImage::Format_Indexed8);
+	quantized.setColorTable(colors);
+
+	for (int y = 0; y < image.height(); ++y)
+	{
+		const QRgb* source = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+		uchar* target = quantized.scanLine(y);
+
+		for (int x = 0; x < image.width(); ++x)
+		{
+			target[x] = lookup[binOf(source[x])];
+		}
+	}
+
+	if (psnr(image, quantized.convertToFormat(QImage::Format_ARGB32)) < m_minimumPsnr)
+	{
+		return QImage();
+	}
+
+	return quantized;
+}
+
+double TileOptimizer::psnr(const QImage& original, const QImage& candidate)
+{
+	double error = 0.0;
+
+	for (int y = 0; y < original.height(); ++y)
+	{
+		const QRgb* a = reinterpret_cast<const QRgb*>(original.constScanLine(y));
+		const QRgb* b = reinterpret_cast<const QRgb*>(candidate.constScanLine(y));
+
+		for (int x = 0; x < original.width(); ++x)
+		{
+			int red = qRed(a[x]) - qRed(b[x]);
+			int green = qGreen(a[x]) - qGreen(b[x]);
+			int blue = qBlue(a[x]) - qBlue(b[x]);
+
+			error += red * red + green * green + blue * blue;
+		}
+	}
+
+	double mse = error / (3.0 * original.width() * original.height());
+
+	if (mse <= 0.0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TILEOPTIMIZER_H
+#define TILEOPTIMIZER_H
+
+#include <QByteArray>
+#include <QImage>
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+
+class PngBandEncoder;
+
+class WAIFU2UGC_CORE_EXPORT TileOptimizer
+{
+public:
+	enum Kind {
+		ARGB,
+		RGB,
+		PALETTE
+	};
+
+	struct Options
+	{
+		bool optimize = false;
+		bool quantize = false;
+	};
+
+	struct Result
+	{
+		QByteArray data;
+		qint64 baselineBytes = 0;
+		Kind kind = ARGB;
+	};
+
+	// A canceled token gives an empty result, checked between the encoding steps.
+	static Result encode(const QImage& tile, const Options& options, const PngBandEncoder* bands = nullptr,
+						 const CancellationToken& token = CancellationToken());
+
+	static QByteArray encodePng(const QImage& image);
+	static QByteArray stripAncillaryChunks(const QByteArray& png);
+
+private:
+	static bool isOpaque(const QImage& image);
+	static QImage toExactPalette(const QImage& image);
+	static QImage toQuantizedPalette(const QImage& image);
+	static double psnr(const QImage& original, const QImage& candidate);
+
+private:
+	static constexpr double m_minimumPsnr = 40.0;
+};
+
+#endif // TILEOPTIMIZER_H
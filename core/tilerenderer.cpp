@@ -0,0 +1,473 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "tilerenderer.h"
+#include "facemask.h"
+#include "pngbandencoder.h"
+#include "stagetuner.h"
+#include "tilewriter.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QPainter>
+#include <QSaveFile>
+#include <QWaitCondition>
+
+QString TileRenderer::Report::text(bool optimized) const
+{
+	QLocale locale;
+	QString report = tr("%1 tiles written, %2.").arg(written).arg(locale.formattedDataSize(writtenBytes));
+
+	if (optimized)
+	{
+		report += " " + tr("%1 saved (%2%), %3 opaque RGB and %4 palette tiles.")
+				  .arg(locale.formattedDataSize(baselineBytes - writtenBytes))
+				  .arg(baselineBytes > 0 ? 100.0 * (baselineBytes - writtenBytes) / baselineBytes : 0.0, 0, 'f', 1)
+				  .arg(rgbTiles)
+				  .arg(paletteTiles);
+	}
+
+	return report;
+}
+
+TileRenderer::TileRenderer(const ExportPlan& plan) : m_plan(plan)
+{
+}
+
+const ExportPlan& TileRenderer::plan() const
+{
+	return m_plan;
+}
+
+PngBandEncoder TileRenderer::templateBands(const QImage& templateImage) const
+{
+	QVector<QRect> faceRects;
+
+	for (const auto& face : m_plan.data().faces())
+	{
+		if (face.enabled())
+		{
+			faceRects.append(face.faceRect());
+		}
+	}
+
+	return PngBandEncoder(templateImage, faceRects);
+}
+
+void TileRenderer::setTemplateBands(const PngBandEncoder& bands)
+{
+	m_templateBands = bands;
+}
+
+void TileRenderer::setCompressedFaces(const QHash<QString, CompressedImage>& faces)
+{
+	m_compressedFaces = faces;
+}
+
+TileRenderer::Report TileRenderer::render(const QHash<QString, QImage>& images, const QStringList& directories, const TileOptimizer::Options& options,
+										  const QVector<int>& selection, int threads, const Callbacks& callbacks) const
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	const ExportData& data = m_plan.data();
+	const QVector<ExportPlan::Tile>& tiles = m_plan.tiles();
+
+	QMap<FaceData::FaceIndex, QImage> faceImages;
+	QMap<FaceData::FaceIndex, CompressedImage> compressedFaces;
+
+	// Tiles are composed on this thread only, the unpacked blocks go when the export ends.
+	CompressedImage::BlockCache blockCache;
+
+	for (const auto& face : data.faces())
+	{
+		if (face.enabled())
+		{
+			if (m_compressedFaces.contains(face.face()))
+			{
+				compressedFaces[face.index()] = m_compressedFaces.value(face.face());
+			}
+			else
+			{
+				faceImages[face.index()] = images.value(face.face());
+			}
+		}
+	}
+
+	// Masks are rasterized once per export, their faces kept premultiplied for the blend kernel.
+	QMap<FaceData::FaceIndex, FaceMask> masks;
+
+	for (const auto& face : data.faces())
+	{
+		if (face.enabled() && !face.mask().isEmpty())
+		{
+			masks[face.index()] = FaceMask::build(face.mask(), face.faceRect().size());
+
+			if (!compressedFaces.contains(face.index()))
+			{
+				faceImages[face.index()] = faceImages[face.index()].convertToFormat(QImage::Format_ARGB32_Premultiplied);
+			}
+		}
+	}
+
+	const QImage templateImage = images.value("template");
+
+	PngBandEncoder bands = m_templateBands.isNull() ? templateBands(templateImage) : m_templateBands;
+
+	// With fewer tiles than threads the pool would idle, so large tiles spread their own bands over it.
+	bands.setParallel(selection.count() < QThreadPool::globalInstance()->maxThreadCount() &&
+					  qint64(templateImage.width()) * templateImage.height() >= m_parallelEncodePixels);
+
+	const PngBandEncoder* sharedBands = &bands;
+	const TileWriter writer(directories);
+	const TileWriter* sharedWriter = &writer;
+
+	const CancellationToken token = callbacks.token;
+
+	Report report;
+
+	int total = selection.count();
+
+	// Tiles are composed on this thread, encoded on the global pool and written on a pool of their own. Every render in
+	// the process encodes on that one pool, so concurrent exports share the cores rather than each claiming all of them;
+	// the tuner only caps how many of the pool's threads this render's tiles take at once.
+	StageTuner tuner(StageTuner::Limits::load(), threads, total);
+	StageTuner* sharedTuner = &tuner;
+
+	QMutex mutex;
+	QWaitCondition tileFinished;
+	int pending = 0;
+	int encoding = 0;
+	QVector<bool> written(total, false);
+
+	auto encoded = [&]() {
+		QMutexLocker lock(&mutex);
+
+		--encoding;
+		tileFinished.wakeAll();
+	};
+
+	auto finish = [&](int index, const TileOptimizer::Result& result) {
+		QMutexLocker lock(&mutex);
+
+		--pending;
+		tileFinished.wakeAll();
+
+		// Tiles dropped by a cancel were never started on disk, they are neither written nor failed.
+		if (result.data.isEmpty() && token.isCanceled())
+		{
+			return;
+		}
+
+		if (result.data.isEmpty())
+		{
+			++report.failed;
+			return;
+		}
+
+		++report.written;
+		report.writtenBytes += result.data.size();
+		report.baselineBytes += result.baselineBytes;
+		written[index] = true;
+
+		if (result.kind == TileOptimizer::RGB) ++report.rgbTiles;
+		else if (result.kind == TileOptimizer::PALETTE) ++report.paletteTiles;
+	};
+
+	QThreadPool writers;
+	QThreadPool* sharedWriters = &writers;
+
+	for (int i = 0; i < total; ++i)
+	{
+		if (token.isCanceled()) break;
+
+		writers.setMaxThreadCount(tuner.writers());
+
+		{
+			QMutexLocker lock(&mutex);
+
+			while (pending >= tuner.inFlight())
+			{
+				tileFinished.wait(&mutex);
+			}
+		}
+
+		QElapsedTimer composing;
+		composing.start();
+
+		const ExportPlan::Tile& tile = tiles[selection[i]];
+		QImage output = templateImage.copy();
+
+		bool masked = std::any_of(tile.blits.begin(), tile.blits.end(), [&masks](const ExportPlan::Blit& blit) {
+			return masks.contains(blit.face);
+		});
+
+		if (masked)
+		{
+			output = output.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+		}
+
+		{
+			QPainter painter(&output);
+
+			for (const ExportPlan::Blit& blit : tile.blits)
+			{
+				if (token.isCanceled()) break;
+
+				const FaceData& face = *data.faces().constFind(blit.face);
+
+				if (callbacks.status)
+				{
+					callbacks.status(tr("Processing face '%1' x:%2, y:%3!").arg(face.text()).arg(blit.position.x()).arg(blit.position.y()));
+				}
+
+				if (!masks.contains(blit.face))
+				{
+					QRect source(QPoint(face.faceRect().width() * blit.position.x(), face.faceRect().height() * blit.position.y()), face.faceRect().size());
+					auto compressed = compressedFaces.constFind(blit.face);
+
+					if (compressed != compressedFaces.constEnd())
+					{
+						painter.drawImage(face.faceRect().topLeft(), compressed->copy(source, blockCache), QRect(QPoint(0, 0), source.size()), Qt::NoFormatConversion);
+					}
+					else
+					{
+						painter.drawImage(face.faceRect().topLeft(), faceImages[blit.face], source, Qt::NoFormatConversion);
+					}
+				}
+			}
+		}
+
+		// Faces never overlap, so the masked ones can go after the painter is done with the tile.
+		for (const ExportPlan::Blit& blit : tile.blits)
+		{
+			if (token.isCanceled()) break;
+
+			auto mask = masks.constFind(blit.face);
+
+			if (mask != masks.constEnd())
+			{
+				const FaceData& face = *data.faces().constFind(blit.face);
+				QPoint source(face.faceRect().width() * blit.position.x(), face.faceRect().height() * blit.position.y());
+
+				auto compressed = compressedFaces.constFind(blit.face);
+
+				if (compressed != compressedFaces.constEnd())
+				{
+					QImage cell = compressed->copy(QRect(source, face.faceRect().size()), blockCache).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+					mask->blend(output, face.faceRect().topLeft(), cell, QPoint(0, 0));
+				}
+				else
+				{
+					mask->blend(output, face.faceRect().topLeft(), faceImages[blit.face], source);
+				}
+			}
+		}
+
+		// A half composed tile is dropped here rather than encoded.
+		if (token.isCanceled()) break;
+
+		if (masked)
+		{
+			output = output.convertToFormat(templateImage.format());
+		}
+
+		if (callbacks.status)
+		{
+			callbacks.status(tr("Saving %1...").arg(tile.fileName));
+		}
+
+		tuner.record(StageTuner::COMPOSE, composing.nsecsElapsed());
+
+		QString fileName = tile.fileName;
+
+		auto sink = callbacks.sink;
+
+		{
+			QMutexLocker lock(&mutex);
+
+			while (encoding >= tuner.encoders())
+			{
+				tileFinished.wait(&mutex);
+			}
+
+			++pending;
+			++encoding;
+		}
+
+		QtConcurrent::run(QThreadPool::globalInstance(), [=, &finish, &encoded]() {
+			QElapsedTimer encodeTimer;
+			encodeTimer.start();
+
+			TileOptimizer::Result result = TileOptimizer::encode(output, options, sharedBands, token);
+			sharedTuner->record(StageTuner::ENCODE, encodeTimer.nsecsElapsed());
+
+			encoded();
+
+			if (token.isCanceled())
+			{
+				finish(i, TileOptimizer::Result());
+				return;
+			}
+
+			QtConcurrent::run(sharedWriters, [=, &finish]() mutable {
+				QElapsedTimer writing;
+				writing.start();
+
+				if (!(sink ? sink(fileName, result.data) : sharedWriter->write(fileName, result.data)))
+				{
+					result.data.clear();
+				}
+
+				sharedTuner->record(StageTuner::WRITE, writing.nsecsElapsed());
+				sharedTuner->tileDone();
+
+				finish(i, result);
+			});
+		});
+
+		report.pixelWork += m_plan.pixelWork(tile);
+
+		if (callbacks.progress)
+		{
+			callbacks.progress(qreal(i + 1) / total);
+		}
+	}
+
+	// The global pool runs other work too, so this render waits for its own tiles rather than for the pool.
+	{
+		QMutexLocker lock(&mutex);
+
+		while (pending > 0)
+		{
+			tileFinished.wait(&mutex);
+		}
+	}
+
+	writers.waitForDone();
+
+	for (int i = 0; i < total; ++i)
+	{
+		if (written[i])
+		{
+			report.files.append(tiles[selection[i]].fileName);
+		}
+	}
+
+	report.pipeline = tuner.text();
+
+	report.elapsed = timer.nsecsElapsed();
+	report.cancelLatency = token.sinceCancel();
+
+	return report;
+}
+
+QString TileRenderer::manifestName(const ShardSpec& shard)
+{
+	return QString("waifu2ugc-shard-%1-of-%2.json").arg(shard.index()).arg(shard.count());
+}
+
+bool TileRenderer::writeManifest(const QString& directory, const ShardSpec& shard, const Report& report) const
+{
+	QJsonObject manifest {
+		{ "shard", shard.toString() },
+		{ "tiles", m_plan.tiles().count() },
+		{ "files", QJsonArray::fromStringList(report.files) }
+	};
+
+	QSaveFile file(QDir(directory).filePath(manifestName(shard)));
+
+	return file.open(QIODevice::WriteOnly) &&
+		   file.write(QJsonDocument(manifest).toJson()) >= 0 &&
+		   file.commit();
+}
+
+// A merge succeeds when every shard reported in, and together they wrote each tile exactly once.
+bool TileRenderer::verifyShards(const QString& directory, int count, QStringList* problems) const
+{
+	QDir path(directory);
+	QHash<QString, int> seen;
+	QStringList issues;
+
+	for (int i = 0; i < count; ++i)
+	{
+		ShardSpec shard;
+		ShardSpec::parse(QString("%1/%2").arg(i).arg(count), shard);
+
+		QFile file(path.filePath(manifestName(shard)));
+
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			issues.append(tr("Shard %1 has no manifest.").arg(shard.toString()));
+			continue;
+		}
+
+		const QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+
+		if (manifest.value("tiles").toInt() != m_plan.tiles().count())
+		{
+			issues.append(tr("Shard %1 was rendered from a different job.").arg(shard.toString()));
+		}
+
+		for (const auto& value : manifest.value("files").toArray())
+		{
+			++seen[value.toString()];
+		}
+	}
+
+	for (const ExportPlan::Tile& tile : m_plan.tiles())
+	{
+		int hits = seen.take(tile.fileName);
+
+		if (hits == 0)
+		{
+			issues.append(tr("Missing tile %1.").arg(tile.fileName));
+		}
+		else if (hits > 1)
+		{
+			issues.append(tr("Tile %1 was written by %2 shards.").arg(tile.fileName).arg(hits));
+		}
+		else if (!path.exists(tile.fileName))
+		{
+			issues.append(tr("Tile %1 is listed but not on disk.").arg(tile.fileName));
+		}
+	}
+
+	for (auto it = seen.constBegin(); it != seen.constEnd(); ++it)
+	{
+		issues.append(tr("Unexpected tile %1.").arg(it.key()));
+	}
+
+	if (problems != nullptr)
+	{
+		*problems = issues;
+	}
+
+	return issues.isEmpty();
+}
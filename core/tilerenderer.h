@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QImage>
+#include <QStringList>
+
+#include <functional>
+
+#include "waifu2ugccore.h"
+#include "cancellationtoken.h"
+#include "compressedimage.h"
+#include "exportplan.h"
+#include "pngbandencoder.h"
+#include "shardspec.h"
+#include "tileoptimizer.h"
+
+class WAIFU2UGC_CORE_EXPORT TileRenderer
+{
+	Q_DECLARE_TR_FUNCTIONS(TileRenderer)
+
+public:
+	struct Report
+	{
+		int written = 0;
+		int failed = 0;
+		int rgbTiles = 0;
+		int paletteTiles = 0;
+
+		qint64 writtenBytes = 0;
+		qint64 baselineBytes = 0;
+
+		qint64 pixelWork = 0;
+		qint64 elapsed = 0; // nanoseconds
+		qint64 cancelLatency = 0; // nanoseconds from the cancel until every stage had stopped, 0 if not canceled
+
+		QStringList files;
+		QString pipeline; // the threads the tuner settled on and the time per stage, see StageTuner
+
+		QString text(bool optimized) const;
+	};
+
+	struct Callbacks
+	{
+		std::function<void(const QString&)> status;
+		std::function<void(qreal)> progress;
+		CancellationToken token;
+
+		// Takes the encoded tiles instead of the directories, called from the writing threads.
+		std::function<bool(const QString& fileName, const QByteArray& data)> sink;
+	};
+
+	explicit TileRenderer(const ExportPlan& plan);
+
+	const ExportPlan& plan() const;
+
+	// The bands of the template, encoded once by callers rendering the same plan and template several times.
+	PngBandEncoder templateBands(const QImage& templateImage) const;
+	void setTemplateBands(const PngBandEncoder& bands);
+
+	// Faces found here instead of in the images given to render are unpacked one block of rows at a time.
+	void setCompressedFaces(const QHash<QString, CompressedImage>& faces);
+
+	// Tiles are rendered and encoded once, whatever the number of directories receiving them.
+	Report render(const QHash<QString, QImage>& images, const QStringList& directories, const TileOptimizer::Options& options,
+				  const QVector<int>& selection, int threads, const Callbacks& callbacks) const;
+
+	static QString manifestName(const ShardSpec& shard);
+	bool writeManifest(const QString& directory, const ShardSpec& shard, const Report& report) const;
+	bool verifyShards(const QString& directory, int count, QStringList* problems) const;
+
+private:
+	ExportPlan m_plan;
+	QHash<QString, CompressedImage> m_compressedFaces;
+	PngBandEncoder m_templateBands;
+
+	static constexpr qint64 m_parallelEncodePixels = 1024 * 1024;
+};
+
+#endif // TILERENDERER_H
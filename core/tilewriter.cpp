@@ -0,0 +1,161 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "tilewriter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStorageInfo>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TileWriter::TileWriter(const QStringList& directories) : m_directories(directories)
+{
+	QByteArray device = directories.isEmpty() ? QByteArray() : QStorageInfo(directories.first()).device();
+
+	for (const QString& directory : directories)
+	{
+		m_sameDevice.append(!device.isEmpty() && QStorageInfo(directory).device() == device);
+	}
+}
+
+const QStringList& TileWriter::directories() const
+{
+	return m_directories;
+}
+
+bool TileWriter::write(const QString& fileName, const QByteArray& data) const
+{
+	if (m_directories.isEmpty())
+	{
+		return false;
+	}
+
+	QString primary = QDir(m_directories.first()).filePath(fileName);
+
+	if (!writeFile(primary, data))
+	{
+		return false;
+	}
+
+	for (int i = 1; i < m_directories.count(); ++i)
+	{
+		QString path = QDir(m_directories[i]).filePath(fileName);
+
+		if (!(m_sameDevice[i] && cloneFile(primary, path)) && !writeFile(path, data))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool TileWriter::writeFile(const QString& path, const QByteArray& data)
+{
+	QSaveFile file(path);
+
+	return file.open(QIODevice::WriteOnly) && file.write(data) == data.size() && file.commit();
+}
+
+// Shares the blocks on filesystems supporting reflinks, lets the kernel copy them otherwise.
+// Returns false when neither is possible, the caller then writes the bytes it still has.
+bool TileWriter::cloneFile(const QString& source, const QString& target)
+{
+#ifdef Q_OS_LINUX
+	int input = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+
+	if (input < 0)
+	{
+		return false;
+	}
+
+	// Cloned next to the target and renamed over it, like QSaveFile does for written tiles. The temporary name is
+	// unique, so processes writing the same tile, e.g. two shards, never clone into one file.
+	QByteArray temporary = QFile::encodeName(target) + ".XXXXXX";
+	int output = ::mkostemp(temporary.data(), O_CLOEXEC);
+
+	if (output < 0)
+	{
+		::close(input);
+		return false;
+	}
+
+	::fchmod(output, 0644);
+
+	bool copied = false;
+
+#ifdef FICLONE
+	copied = ::ioctl(output, FICLONE, input) == 0;
+#endif
+
+	if (!copied)
+	{
+		off_t remaining = ::lseek(input, 0, SEEK_END);
+		::lseek(input, 0, SEEK_SET);
+
+		while (remaining > 0)
+		{
+			ssize_t count = ::copy_file_range(input, nullptr, output, nullptr, size_t(remaining), 0);
+
+			if (count <= 0)
+			{
+				break;
+			}
+
+			remaining -= count;
+		}
+
+		copied = remaining == 0;
+	}
+
+	::close(output);
+	::close(input);
+
+	if (copied)
+	{
+		copied = ::rename(temporary.constData(), QFile::encodeName(target).constData()) == 0;
+	}
+
+	if (!copied)
+	{
+		::unlink(temporary.constData());
+	}
+
+	return copied;
+#else
+	Q_UNUSED(source)
+	Q_UNUSED(target)
+
+	return false;
+#endif
+}
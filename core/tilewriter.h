@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef TILEWRITER_H
+#define TILEWRITER_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+#include "waifu2ugccore.h"
+
+// Saves every encoded tile to one or more directories, e.g. the NXL and the Steam client at once. The first directory
+// gets the bytes, the others a reflink or kernel copy of that file when they share its filesystem, and their own
+// single write otherwise. Tiles only appear under their name once complete, so an export canceled or killed mid-write
+// leaves no truncated tiles behind.
+class WAIFU2UGC_CORE_EXPORT TileWriter
+{
+public:
+	explicit TileWriter(const QStringList& directories);
+
+	const QStringList& directories() const;
+
+	bool write(const QString& fileName, const QByteArray& data) const;
+
+private:
+	static bool writeFile(const QString& path, const QByteArray& data);
+	static bool cloneFile(const QString& source, const QString& target);
+
+private:
+	QStringList m_directories;
+	QVector<bool> m_sameDevice;
+};
+
+#endif // TILEWRITER_H
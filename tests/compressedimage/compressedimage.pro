@@ -0,0 +1,26 @@
+QT += testlib gui
+QT -= qml quick
+
+TARGET = tst_compressedimage
+
+CONFIG += c++11 testcase console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        tst_compressedimage.cpp
+
+INCLUDEPATH += $$PWD/../../core
+DEPENDPATH += $$PWD/../../core
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../../core/release/
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../../core/debug/
+else: LIBS += -L$$OUT_PWD/../../core/
+
+LIBS += -lwaifu2ugc-core
+
+waifu2ugc_static {
+    DEFINES += WAIFU2UGC_CORE_STATIC
+    unix: LIBS += -lz
+}
@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "compressedimage.h"
+
+#include <QtTest>
+#include <QImage>
+
+class TestCompressedImage : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void cells_data();
+	void cells();
+	void spanningRect();
+	void indexed();
+
+private:
+	static QImage pattern(const QSize& size);
+};
+
+static const QSize cellSize(64, 48);
+static constexpr int columns = 5;
+static constexpr int rows = 3;
+
+QImage TestCompressedImage::pattern(const QSize& size)
+{
+	QImage image(size, QImage::Format_ARGB32);
+
+	for (int y = 0; y < size.height(); ++y)
+	{
+		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+
+		for (int x = 0; x < size.width(); ++x)
+		{
+			line[x] = qRgba(x & 0xff, y & 0xff, (x * 7 + y * 3) & 0xff, 255 - (y & 0x3f));
+		}
+	}
+
+	return image;
+}
+
+void TestCompressedImage::cells_data()
+{
+	QTest::addColumn<bool>("rowsFirst");
+
+	QTest::newRow("rows first") << true;
+	QTest::newRow("columns first") << false;
+}
+
+// However the tiles walk the face grid, every cell is unpacked exactly once.
+void TestCompressedImage::cells()
+{
+	QFETCH(bool, rowsFirst);
+
+	QImage image = pattern(QSize(cellSize.width() * columns, cellSize.height() * rows));
+	CompressedImage compressed = CompressedImage::compress(image, cellSize);
+	CompressedImage::BlockCache cache;
+
+	for (int outer = 0; outer < (rowsFirst ? rows : columns); ++outer)
+	{
+		for (int inner = 0; inner < (rowsFirst ? columns : rows); ++inner)
+		{
+			QPoint cell = rowsFirst ? QPoint(inner, outer) : QPoint(outer, inner);
+			QRect rect(QPoint(cell.x() * cellSize.width(), cell.y() * cellSize.height()), cellSize);
+
+			QCOMPARE(compressed.copy(rect, cache), image.copy(rect));
+		}
+	}
+
+	QCOMPARE(cache.inflates(), columns * rows);
+}
+
+void TestCompressedImage::spanningRect()
+{
+	QImage image = pattern(QSize(cellSize.width() * columns + 10, cellSize.height() * rows + 7));
+	CompressedImage compressed = CompressedImage::compress(image, cellSize);
+	CompressedImage::BlockCache cache;
+
+	QRect rect(30, 20, cellSize.width() * 2, cellSize.height() * 2);
+
+	QCOMPARE(compressed.copy(rect, cache), image.copy(rect));
+	QCOMPARE(cache.inflates(), 9);
+
+	QRect edge(image.width() - 20, image.height() - 15, 20, 15);
+
+	QCOMPARE(compressed.copy(edge, cache), image.copy(edge));
+}
+
+// Below 8 bits per pixel the blocks span whole rows.
+void TestCompressedImage::indexed()
+{
+	QImage image = pattern(QSize(cellSize.width() * columns, cellSize.height() * rows)).convertToFormat(QImage::Format_Mono);
+	CompressedImage compressed = CompressedImage::compress(image, cellSize);
+	CompressedImage::BlockCache cache;
+
+	QCOMPARE(compressed.blockSize(), QSize(image.width(), cellSize.height()));
+
+	QRect rect(0, 30, image.width(), cellSize.height());
+
+	QCOMPARE(compressed.copy(rect, cache), image.copy(rect));
+	QCOMPARE(cache.inflates(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestCompressedImage)
+
+#include "tst_compressedimage.moc"
@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "exportplan.h"
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+
+class TestExportPlan : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void roundTrip();
+	void loadFile();
+	void rejectCellOutsideFace();
+	void calibrationPerThread();
+
+private:
+	static ExportData cube();
+};
+
+// Front and right faces on a 128x64 template, 3x2 and 2x2 cells.
+ExportData TestExportPlan::cube()
+{
+	QJsonObject json {
+		{ "template", "file:///template.png" },
+		{ "faces", QJsonObject {
+			{ "front", QJsonObject {
+				{ "enabled", true },
+				{ "faceRect", QJsonArray { 0, 0, 32, 32 } },
+				{ "horizontalCount", 3 },
+				{ "verticalCount", 2 },
+				{ "image", "file:///front.png" }
+			} },
+			{ "right", QJsonObject {
+				{ "enabled", true },
+				{ "faceRect", QJsonArray { 64, 0, 32, 32 } },
+				{ "horizontalCount", 2 },
+				{ "verticalCount", 2 },
+				{ "image", "file:///right.png" }
+			} }
+		} }
+	};
+
+	ExportData data;
+	QString error;
+
+	if (!ExportData::fromJson(json, data, &error))
+	{
+		qWarning() << error;
+	}
+
+	return data;
+}
+
+void TestExportPlan::roundTrip()
+{
+	ExportPlan plan = ExportPlan::compile(cube(), QSize(128, 64));
+	QVERIFY(!plan.tiles().isEmpty());
+
+	ExportPlan restored;
+	QString error;
+
+	QVERIFY2(ExportPlan::fromJson(plan.toJson(), restored, &error), qPrintable(error));
+
+	QCOMPARE(restored.tileSize(), plan.tileSize());
+	QCOMPARE(restored.tiles().count(), plan.tiles().count());
+
+	for (int i = 0; i < plan.tiles().count(); ++i)
+	{
+		const ExportPlan::Tile& tile = plan.tiles()[i];
+		const ExportPlan::Tile& copy = restored.tiles()[i];
+
+		QCOMPARE(copy.fileName, tile.fileName);
+		QCOMPARE(copy.mainIndex, tile.mainIndex);
+		QCOMPARE(copy.mainPoint, tile.mainPoint);
+		QCOMPARE(copy.blits.count(), tile.blits.count());
+
+		for (int j = 0; j < tile.blits.count(); ++j)
+		{
+			QCOMPARE(copy.blits[j].face, tile.blits[j].face);
+			QCOMPARE(copy.blits[j].position, tile.blits[j].position);
+		}
+	}
+
+	QCOMPARE(restored.toJson(), plan.toJson());
+	QCOMPARE(restored.select(ShardSpec()), plan.select(ShardSpec()));
+}
+
+// The file --plan writes is what --run-plan reads.
+void TestExportPlan::loadFile()
+{
+	ExportPlan plan = ExportPlan::compile(cube(), QSize(128, 64));
+
+	QTemporaryDir directory;
+	QVERIFY(directory.isValid());
+
+	QFile file(directory.filePath("cube.plan.json"));
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write(QJsonDocument(plan.toJson()).toJson());
+	file.close();
+
+	ExportPlan loaded;
+	QString error;
+
+	QVERIFY2(ExportPlan::load(file.fileName(), loaded, &error), qPrintable(error));
+	QCOMPARE(loaded.toJson(), plan.toJson());
+
+	QVERIFY(!ExportPlan::load(directory.filePath("missing.json"), loaded, &error));
+	QVERIFY(!error.isEmpty());
+}
+
+void TestExportPlan::rejectCellOutsideFace()
+{
+	QJsonObject json = ExportPlan::compile(cube(), QSize(128, 64)).toJson();
+
+	QJsonArray tiles = json["tiles"].toArray();
+	QJsonObject tile = tiles[0].toObject();
+	tile["x"] = 99;
+	tiles[0] = tile;
+	json["tiles"] = tiles;
+
+	ExportPlan plan;
+	QString error;
+
+	QVERIFY(!ExportPlan::fromJson(json, plan, &error));
+	QVERIFY(!error.isEmpty());
+}
+
+// A render taking 10 ms on 4 threads cost 40 ms of thread time, the estimate spreads that over its own threads.
+void TestExportPlan::calibrationPerThread()
+{
+	ExportPlan::Calibration calibration;
+	calibration.record(1000 * 1000, 10 * 1000 * 1000, 4, 1500 * 1000);
+
+	QCOMPARE(calibration.nanosecondsPerPixel, 40.0);
+	QCOMPARE(calibration.bytesPerPixel, 1.5);
+
+	ExportPlan plan = ExportPlan::compile(cube(), QSize(128, 64));
+	ExportPlan::Estimate estimate = plan.estimate(plan.select(ShardSpec()), calibration);
+
+	QVERIFY(estimate.calibrated);
+	QVERIFY(qFuzzyCompare(estimate.seconds, estimate.pixelWork * 40.0 / 1e9 / estimate.threads));
+}
+
+QTEST_GUILESS_MAIN(TestExportPlan)
+
+#include "tst_exportplan.moc"
@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "faceprocessor.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QtTest>
+#include <QImage>
+
+class TestFaceProcessor : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void scaledSmall();
+	void scaledLarge();
+	void cancelDuringScale();
+
+private:
+	static QImage gradient(int width, int height);
+};
+
+// The export stages promise to notice a cancel within this long, see TemplateExporter.
+static constexpr qint64 cancelLatencyBudget = 50 * 1000 * 1000; // nanoseconds
+
+QImage TestFaceProcessor::gradient(int width, int height)
+{
+	QImage image(width, height, QImage::Format_ARGB32);
+
+	for (int y = 0; y < height; ++y)
+	{
+		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+
+		for (int x = 0; x < width; ++x)
+		{
+			line[x] = qRgba(x * 255 / width, y * 255 / height, (x + y) & 0xff, 255 - (x & 0x7f));
+		}
+	}
+
+	return image;
+}
+
+void TestFaceProcessor::scaledSmall()
+{
+	QImage image = gradient(64, 48);
+	QSize size(100, 30);
+
+	QCOMPARE(FaceProcessor::scaled(image, size), image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+}
+
+// Scales large enough to run on the scaling pool give exactly Qt's own result.
+void TestFaceProcessor::scaledLarge()
+{
+	QImage image = gradient(1500, 1000);
+	QSize size(1700, 900);
+
+	QCOMPARE(FaceProcessor::scaled(image, size), image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+}
+
+// A cancel during a scale that takes far longer than the budget returns within the budget.
+void TestFaceProcessor::cancelDuringScale()
+{
+	QImage image = gradient(3000, 3000);
+	CancellationToken token;
+
+	QFuture<void> canceler = QtConcurrent::run([token]() {
+		QThread::msleep(20);
+		token.cancel();
+	});
+
+	QImage result = FaceProcessor::scaled(image, QSize(6000, 6000), token);
+	qint64 latency = token.sinceCancel();
+
+	canceler.waitForFinished();
+
+	if (!result.isNull())
+	{
+		QSKIP("The scale finished before the cancel");
+	}
+
+	QVERIFY2(latency <= cancelLatencyBudget, qPrintable(QString("Cancel took %1 ms").arg(latency / 1e6)));
+}
+
+QTEST_GUILESS_MAIN(TestFaceProcessor)
+
+#include "tst_faceprocessor.moc"
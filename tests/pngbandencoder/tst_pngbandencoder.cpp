@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "pngbandencoder.h"
+
+#include <QtTest>
+#include <QBuffer>
+#include <QImage>
+#include <QImageReader>
+#include <QPainter>
+
+class TestPngBandEncoder : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void decodes_data();
+	void decodes();
+	void cachedBandsMatch_data();
+	void cachedBandsMatch();
+	void repeatable();
+	void canceled();
+
+private:
+	static QImage pattern(const QSize& size, bool alpha);
+	static QImage tile(const QImage& templateImage);
+	static QImage decode(const QByteArray& png);
+};
+
+// Both faces sit between template only bands, which the encoder caches.
+static const QRect firstFace(40, 30, 50, 40);
+static const QRect secondFace(120, 100, 60, 35);
+
+QImage TestPngBandEncoder::pattern(const QSize& size, bool alpha)
+{
+	QImage image(size, alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+	for (int y = 0; y < size.height(); ++y)
+	{
+		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+
+		for (int x = 0; x < size.width(); ++x)
+		{
+			line[x] = qRgba(x & 0xff, (y * 3) & 0xff, (x ^ y) & 0xff, alpha ? 255 - (y & 0x7f) : 255);
+		}
+	}
+
+	return image;
+}
+
+// The template with something else drawn over its faces, as the renderer produces them.
+QImage TestPngBandEncoder::tile(const QImage& templateImage)
+{
+	QImage image = templateImage.copy();
+
+	QPainter painter(&image);
+	painter.setCompositionMode(QPainter::CompositionMode_Source);
+	painter.fillRect(firstFace, QColor(200, 10, 60, 180));
+	painter.drawImage(secondFace.topLeft(), pattern(secondFace.size(), true).mirrored(true, false));
+	painter.end();
+
+	return image;
+}
+
+QImage TestPngBandEncoder::decode(const QByteArray& png)
+{
+	QByteArray data = png;
+	QBuffer buffer(&data);
+	QImageReader reader(&buffer, "png");
+	QImage image;
+
+	if (!reader.read(&image))
+	{
+		qWarning() << reader.errorString();
+		return QImage();
+	}
+
+	return image.convertToFormat(QImage::Format_ARGB32);
+}
+
+void TestPngBandEncoder::decodes_data()
+{
+	QTest::addColumn<bool>("alpha");
+	QTest::addColumn<bool>("parallel");
+
+	QTest::newRow("rgba") << true << false;
+	QTest::newRow("rgb") << false << false;
+	QTest::newRow("rgba parallel") << true << true;
+}
+
+// The spliced stream is a valid PNG holding exactly the tile's pixels.
+void TestPngBandEncoder::decodes()
+{
+	QFETCH(bool, alpha);
+	QFETCH(bool, parallel);
+
+	QImage templateImage = pattern(QSize(200, 160), alpha);
+	QImage expected = tile(templateImage);
+
+	PngBandEncoder encoder(templateImage, { firstFace, secondFace });
+	encoder.setParallel(parallel);
+
+	QVERIFY(encoder.cachedBands() > 0);
+
+	QImage decoded = decode(encoder.encode(expected));
+
+	QVERIFY(!decoded.isNull());
+	QCOMPARE(decoded, expected.convertToFormat(QImage::Format_ARGB32));
+}
+
+void TestPngBandEncoder::cachedBandsMatch_data()
+{
+	QTest::addColumn<bool>("alpha");
+
+	QTest::newRow("rgba") << true;
+	QTest::newRow("rgb") << false;
+}
+
+// A face covering the whole template leaves no band to cache, every band is compressed from the tile itself.
+void TestPngBandEncoder::cachedBandsMatch()
+{
+	QFETCH(bool, alpha);
+
+	QImage templateImage = pattern(QSize(200, 160), alpha);
+	QImage image = tile(templateImage);
+
+	PngBandEncoder cached(templateImage, { firstFace, secondFace });
+	PngBandEncoder uncached(templateImage, { templateImage.rect() });
+
+	QVERIFY(cached.cachedBands() > 0);
+	QCOMPARE(uncached.cachedBands(), 0);
+
+	QImage withCache = decode(cached.encode(image));
+	QImage withoutCache = decode(uncached.encode(image));
+
+	QVERIFY(!withCache.isNull());
+	QCOMPARE(withCache, withoutCache);
+}
+
+// Tiles are compared and deduplicated by their bytes, the same tile must always encode the same.
+void TestPngBandEncoder::repeatable()
+{
+	QImage templateImage = pattern(QSize(200, 160), true);
+	QImage image = tile(templateImage);
+
+	PngBandEncoder encoder(templateImage, { firstFace, secondFace });
+	QByteArray first = encoder.encode(image);
+
+	QVERIFY(!first.isEmpty());
+	QCOMPARE(encoder.encode(image), first);
+
+	PngBandEncoder parallel = encoder;
+	parallel.setParallel(true);
+
+	QCOMPARE(parallel.encode(image), first);
+}
+
+void TestPngBandEncoder::canceled()
+{
+	QImage templateImage = pattern(QSize(200, 160), true);
+
+	PngBandEncoder encoder(templateImage, { firstFace, secondFace });
+	CancellationToken token;
+	token.cancel();
+
+	QVERIFY(encoder.encode(tile(templateImage), token).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestPngBandEncoder)
+
+#include "tst_pngbandencoder.moc"
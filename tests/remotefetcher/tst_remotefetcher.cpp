@@ -0,0 +1,337 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Aruraune
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "remotefetcher.h"
+
+#include <QtTest>
+#include <QBuffer>
+#include <QImage>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+
+// A local HTTP/1.1 stand-in: answers each request from its routes and closes the connection.
+class HttpServer : public QTcpServer
+{
+	Q_OBJECT
+
+public:
+	struct Response
+	{
+		Response() = default;
+		Response(int status, const QList<QPair<QByteArray, QByteArray>>& headers, const QByteArray& body) :
+			status(status), headers(headers), body(body)
+		{
+		}
+
+		int status = 200;
+		QList<QPair<QByteArray, QByteArray>> headers;
+		QByteArray body;
+	};
+
+	struct Request
+	{
+		QByteArray path;
+		QHash<QByteArray, QByteArray> headers;
+	};
+
+	explicit HttpServer(QObject* parent = nullptr) : QTcpServer(parent)
+	{
+		connect(this, &QTcpServer::newConnection, this, &HttpServer::accept);
+	}
+
+	QUrl url(const QString& path) const
+	{
+		return QUrl(QString("http://127.0.0.1:%1%2").arg(serverPort()).arg(path));
+	}
+
+	QHash<QByteArray, Response> routes;
+	QList<Request> requests;
+
+	// Answers are held back this long, so requests overlap. Peak counts the requests waiting for an answer at once.
+	int delay = 0; // milliseconds
+	int waiting = 0;
+	int peak = 0;
+
+private:
+	void accept()
+	{
+		while (QTcpSocket* socket = nextPendingConnection())
+		{
+			connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() { read(socket); });
+			connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+		}
+	}
+
+	void read(QTcpSocket* socket)
+	{
+		QByteArray& buffer = m_buffers[socket];
+		buffer += socket->readAll();
+
+		int end = buffer.indexOf("\r\n\r\n");
+
+		if (end < 0)
+		{
+			return;
+		}
+
+		QList<QByteArray> lines = buffer.left(end).split('\n');
+		m_buffers.remove(socket);
+
+		Request request;
+		request.path = lines.takeFirst().split(' ').value(1);
+
+		for (const QByteArray& line : lines)
+		{
+			int colon = line.indexOf(':');
+			request.headers[line.left(colon).trimmed().toLower()] = line.mid(colon + 1).trimmed();
+		}
+
+		requests.append(request);
+
+		++waiting;
+		peak = std::max(peak, waiting);
+
+		QTimer::singleShot(delay, socket, [this, socket, request]() { respond(socket, request); });
+	}
+
+	void respond(QTcpSocket* socket, const Request& request)
+	{
+		--waiting;
+
+		Response response = routes.value(request.path, Response(404, {}, "Not found"));
+		QByteArray etag;
+
+		for (const auto& header : response.headers)
+		{
+			if (header.first == "ETag") etag = header.second;
+		}
+
+		// Conditional requests for an unchanged entity are answered without a body.
+		if (!etag.isEmpty() && request.headers.value("if-none-match") == etag)
+		{
+			response.status = 304;
+			response.body.clear();
+		}
+
+		QByteArray reply = "HTTP/1.1 " + QByteArray::number(response.status) + " " + reason(response.status) + "\r\n";
+
+		for (const auto& header : response.headers)
+		{
+			reply += header.first + ": " + header.second + "\r\n";
+		}
+
+		reply += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+		reply += "Connection: close\r\n\r\n";
+		reply += response.body;
+
+		socket->write(reply);
+		socket->disconnectFromHost();
+	}
+
+	static QByteArray reason(int status)
+	{
+		switch (status)
+		{
+		case 200: return "OK";
+		case 302: return "Found";
+		case 304: return "Not Modified";
+		case 404: return "Not Found";
+		default: return "Unknown";
+		}
+	}
+
+	QHash<QTcpSocket*, QByteArray> m_buffers;
+};
+
+class TestRemoteFetcher : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void init();
+	void cleanup();
+	void cleanupTestCase();
+
+	void fetch();
+	void cacheHit();
+	void redirect();
+	void notFound();
+	void notAnImage();
+	void connectionLimit();
+
+private:
+	static QByteArray png();
+
+	HttpServer* m_server = nullptr;
+	RemoteFetcher* m_fetcher = nullptr;
+};
+
+// One server for the whole run, each test fetches its own paths so the disk cache of one never answers another.
+// Test mode keeps that cache away from the user's own.
+void TestRemoteFetcher::initTestCase()
+{
+	QStandardPaths::setTestModeEnabled(true);
+	QDir(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("remote")).removeRecursively();
+
+	m_server = new HttpServer(this);
+	QVERIFY(m_server->listen(QHostAddress::LocalHost));
+}
+
+void TestRemoteFetcher::init()
+{
+	m_server->requests.clear();
+	m_server->delay = 0;
+	m_server->waiting = 0;
+	m_server->peak = 0;
+
+	m_fetcher = new RemoteFetcher(this);
+}
+
+void TestRemoteFetcher::cleanup()
+{
+	delete m_fetcher;
+	m_fetcher = nullptr;
+}
+
+void TestRemoteFetcher::cleanupTestCase()
+{
+	delete m_server;
+	m_server = nullptr;
+}
+
+QByteArray TestRemoteFetcher::png()
+{
+	QImage image(16, 8, QImage::Format_ARGB32);
+	image.fill(Qt::magenta);
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	image.save(&buffer, "PNG");
+
+	return data;
+}
+
+void TestRemoteFetcher::fetch()
+{
+	m_server->routes["/image.png"] = HttpServer::Response(200, { { "Content-Type", "image/png" } }, png());
+
+	QString error;
+	QByteArray data = m_fetcher->fetchAndWait(m_server->url("/image.png"), &error);
+
+	QVERIFY2(error.isEmpty(), qPrintable(error));
+	QCOMPARE(data, png());
+	QCOMPARE(m_server->requests.count(), 1);
+}
+
+// A cached copy that must be revalidated is served from the disk cache when the server answers 304.
+void TestRemoteFetcher::cacheHit()
+{
+	m_server->routes["/cached.png"] = HttpServer::Response(200, { { "Content-Type", "image/png" }, { "ETag", "\"v1\"" }, { "Cache-Control", "no-cache" } }, png());
+	QUrl url = m_server->url("/cached.png");
+
+	QString error;
+	QCOMPARE(m_fetcher->fetchAndWait(url, &error), png());
+	QVERIFY2(error.isEmpty(), qPrintable(error));
+
+	QByteArray data = m_fetcher->fetchAndWait(url, &error);
+
+	QVERIFY2(error.isEmpty(), qPrintable(error));
+	QCOMPARE(data, png());
+	QCOMPARE(m_server->requests.count(), 2);
+	QCOMPARE(m_server->requests.last().headers.value("if-none-match"), QByteArray("\"v1\""));
+}
+
+void TestRemoteFetcher::redirect()
+{
+	m_server->routes["/target.png"] = HttpServer::Response(200, { { "Content-Type", "image/png" } }, png());
+	m_server->routes["/moved.png"] = HttpServer::Response(302, { { "Location", m_server->url("/target.png").toEncoded() } }, QByteArray());
+
+	QString error;
+	QByteArray data = m_fetcher->fetchAndWait(m_server->url("/moved.png"), &error);
+
+	QVERIFY2(error.isEmpty(), qPrintable(error));
+	QCOMPARE(data, png());
+	QCOMPARE(m_server->requests.count(), 2);
+	QCOMPARE(m_server->requests.last().path, QByteArray("/target.png"));
+}
+
+void TestRemoteFetcher::notFound()
+{
+	QString error;
+	QByteArray data = m_fetcher->fetchAndWait(m_server->url("/missing.png"), &error);
+
+	QVERIFY(data.isEmpty());
+	QVERIFY(!error.isEmpty());
+}
+
+void TestRemoteFetcher::notAnImage()
+{
+	m_server->routes["/page.png"] = HttpServer::Response(200, { { "Content-Type", "text/html" } }, "<html></html>");
+
+	QString error;
+	QByteArray data = m_fetcher->fetchAndWait(m_server->url("/page.png"), &error);
+
+	QVERIFY(data.isEmpty());
+	QVERIFY(!error.isEmpty());
+}
+
+// More urls than the fetcher's connection cap are downloaded, never more than the cap at once.
+void TestRemoteFetcher::connectionLimit()
+{
+	const int count = 10;
+
+	m_server->delay = 100;
+
+	for (int i = 0; i < count; ++i)
+	{
+		m_server->routes[QString("/many/%1.png").arg(i).toLatin1()] = HttpServer::Response(200, { { "Content-Type", "image/png" } }, png());
+	}
+
+	QSignalSpy spy(m_fetcher, &RemoteFetcher::fetched);
+
+	for (int i = 0; i < count; ++i)
+	{
+		m_fetcher->fetch(m_server->url(QString("/many/%1.png").arg(i)));
+	}
+
+	QTRY_COMPARE_WITH_TIMEOUT(spy.count(), count, 10000);
+
+	for (const auto& arguments : spy)
+	{
+		QVERIFY2(arguments.at(2).toString().isEmpty(), qPrintable(arguments.at(2).toString()));
+	}
+
+	QCOMPARE(m_server->requests.count(), count);
+	QCOMPARE(m_server->peak, m_fetcher->maxConnections());
+}
+
+QTEST_GUILESS_MAIN(TestRemoteFetcher)
+
+#include "tst_remotefetcher.moc"
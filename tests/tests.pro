@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+# Each test is its own QtTest executable, `make check` runs them all.
+SUBDIRS += \
+        compressedimage \
+        exportplan \
+        faceprocessor \
+        pngbandencoder \
+        remotefetcher
@@ -1,40 +1,11 @@
-QT += quick quickcontrols2 widgets
+TEMPLATE = subdirs
 
-CONFIG += c++11
+# The export engine is a plain C++ library so other tools can render tiles without QML;
+# the application, its command line and render service link against it.
+SUBDIRS += \
+        core \
+        app \
+        tests
 
-# The following define makes your compiler emit warnings if you use
-# any Qt feature that has been marked deprecated (the exact warnings
-# depend on your compiler). Refer to the documentation for the
-# deprecated API to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-        exportdata.cpp \
-        main.cpp \
-        templateexporter.cpp \
-        templateface.cpp
-
-RESOURCES += qml.qrc
-
-# Additional import path used to resolve QML modules in Qt Creator's code model
-QML_IMPORT_PATH =
-
-# Additional import path used to resolve QML modules just for Qt Quick Designer
-QML_DESIGNER_IMPORT_PATH =
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
-
-HEADERS += \
-    exportdata.h \
-    facedata.h \
-    templatedata.h \
-    templateexporter.h \
-    templateface.h
+app.depends = core
+tests.depends = core